@@ -0,0 +1,113 @@
+/*
+
+    The CallEnvelope class is the envelope of a call posted to the thread of an object T (by post() or invokeSync()), queued in
+    the MpscQueue of the InboxObject (Qt version) or of the StdEventLoop (Qt-free version) of the thread.
+    The envelopes are allocated by the RecyclingPool, so in steady state posting a call does not reach the system allocator;
+    the pre-allocated envelopes (like the one used by invokeSync()) override release() in order not to be deleted, and discard()
+    in order to know when their call is not going to be executed.
+
+    The CallLanes class is the pair of queues of an inbox: the calls posted in the UrgentLane (control messages, like cancel or
+    reconfigure, and the deletion of the object T) are executed before the pending calls of the BulkLane; anyway, in order not to
+    starve the BulkLane under a continuous urgent traffic, one bulk call is executed every urgentStreakLimit urgent calls.
+
+*/
+
+
+#ifndef CALLENVELOPE_H
+#define CALLENVELOPE_H
+
+#include "mpscqueue.h"
+#include "recyclingpool.h"
+
+
+enum CallLane {BulkLane, UrgentLane};
+
+
+class CallEnvelope : public MpscNode, public RecyclingAllocated
+{
+
+public:
+    virtual ~CallEnvelope(){
+    }
+
+public:
+    virtual void run() = 0;
+    virtual void release(){
+        delete this;            // called after run()
+    }
+    virtual void discard(){
+        release();              // called instead of run(), if the call cannot be executed anymore
+    }
+
+};
+
+
+template <class Functor>
+class FunctorCallEnvelope : public CallEnvelope
+{
+
+public:
+    explicit FunctorCallEnvelope(const Functor &_functor) :
+      functor(_functor){
+    }
+
+private:
+    Functor functor;
+
+public:
+    void run(){
+        functor();
+    }
+
+};
+
+
+class CallLanes
+{
+
+public:
+    CallLanes(){
+        urgentStreak = 0;
+    }
+
+private:
+    MpscQueue urgent;
+    MpscQueue bulk;
+    int urgentStreak;           // the urgent calls executed since the last bulk one
+
+public:
+    void push(CallEnvelope *envelope, CallLane lane){
+        // called by any thread
+        (lane == UrgentLane ? urgent : bulk).push(envelope);
+    }
+    CallEnvelope *next(){
+        // called only by the thread of the inbox; it returns 0 if there is no call ready
+        if(urgentStreak >= urgentStreakLimit){
+            urgentStreak = 0;
+            CallEnvelope *envelope = static_cast<CallEnvelope*>(bulk.pop());       // the starvation guard of the bulk lane
+            if(envelope){
+                return envelope;
+            }
+        }
+        CallEnvelope *envelope = static_cast<CallEnvelope*>(urgent.pop());
+        if(envelope){
+            urgentStreak++;
+            return envelope;
+        }
+        urgentStreak = 0;
+        return static_cast<CallEnvelope*>(bulk.pop());
+    }
+    bool isEmpty() const {return urgent.isEmpty() && bulk.isEmpty();}
+    bool hasUrgent() const {return !urgent.isEmpty();}
+
+private:
+    enum {urgentStreakLimit = 16};
+
+private:
+    CallLanes(const CallLanes &);
+    CallLanes &operator=(const CallLanes &);
+
+};
+
+
+#endif // CALLENVELOPE_H
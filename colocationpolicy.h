@@ -0,0 +1,423 @@
+/*
+
+    The ColocationPolicy class moves the threads of the wrapped objects which exchange a lot of calls into the same L3 cache
+    domain, so their messages do not cross sockets or L3 domains.
+
+    It uses the counters of the TrafficNode objects (trafficnode.h): at every rebalance() it takes the calls posted since the
+    previous one, joins the pairs of objects with at least minimumMessages calls into groups (heaviest pairs first, a group is never
+    larger than a domain), and pins the threads of each group on the cpus of a domain (the one where most of them were already
+    running, with enough free cpus). The threads which are not in a group anymore get back their original affinity.
+    The affinities fixed by the user are respected: a thread whose affinity has been changed by someone else (for example by the
+    constructor of the object T) is never moved, and if its affinity is inside a single domain its group is placed in that domain.
+
+    Every rebalance() gives a ColocationReport, with the decisions and the locality measured since the previous rebalance (the
+    fraction of the tracked calls sent and received inside the same domain), so the improvement given by the previous decisions
+    can be checked. With start() the rebalance is done periodically by an internal thread, which passes the reports to the
+    reporter, if one has been set (by default, the reports are not given to anyone):
+        ColocationPolicy policy;
+        policy.setReporter([](const ColocationReport &report){ std::printf("%s\n", report.toString().c_str()); });
+        policy.start(1000);         // it also enables the tracking of the calls
+        ....... do stuff .....
+        policy.stop();
+
+    The pinning is supported only on Linux; on the other systems the calls are still counted and reported.
+
+*/
+
+
+#ifndef COLOCATIONPOLICY_H
+#define COLOCATIONPOLICY_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "trafficnode.h"
+
+
+struct ColocationDecision
+{
+    enum Action {Pinned, Released, KeptFixed};
+    Action action;
+    uint64_t node;              // TrafficNode::id()
+    long threadId;              // the kernel id of the thread
+    int domain;                 // the target domain, -1 for Released
+    uint64_t messages;          // the calls of the group in the last period
+};
+
+
+struct ColocationReport
+{
+    bool supported;             // false if the threads cannot be pinned on this system
+    int domains;
+    uint64_t messages;          // the tracked calls since the previous rebalance
+    uint64_t localMessages;     // the ones sent and received inside the same domain
+    double locality;            // localMessages / messages, -1 without calls
+    double previousLocality;    // the locality of the period before, so locality - previousLocality is the improvement
+    std::vector<ColocationDecision> decisions;
+
+    std::string toString() const {
+        std::string text = "ColocationPolicy: " + std::to_string(messages) + " calls, locality " + percent(locality) +
+                           " (previous " + percent(previousLocality) + "), " + std::to_string(domains) + " domains";
+        if(!supported){
+            text += ", pinning not supported";
+        }
+        for(size_t i = 0; i < decisions.size(); i++){
+            const ColocationDecision &decision = decisions[i];
+            static const char *actions[] = {"pinned", "released", "kept fixed"};
+            text += "\n    thread " + std::to_string(decision.threadId) + " (node " + std::to_string(decision.node) + ") " +
+                    actions[decision.action];
+            if(decision.domain >= 0){
+                text += " in domain " + std::to_string(decision.domain);
+            }
+            text += ", " + std::to_string(decision.messages) + " calls in its group";
+        }
+        return text;
+    }
+
+private:
+    static std::string percent(double value){
+        return value < 0 ? std::string("n/a") : std::to_string((int)(value * 100 + 0.5)) + "%";
+    }
+};
+
+
+class ColocationPolicy
+{
+
+public:
+    explicit ColocationPolicy(const CpuTopology &_topology = CpuTopology::instance()) :
+      topology(_topology){
+        minimumMessages = 1000;
+        previousLocality = -1;
+        running = false;
+    }
+    ~ColocationPolicy(){
+        stop();
+    }
+
+private:
+    struct EdgeSnapshot {
+        uint64_t epoch;
+        uint64_t messages;
+        uint64_t localMessages;
+    };
+    CpuTopology topology;
+    uint64_t minimumMessages;
+    double previousLocality;
+    std::map<std::pair<uint64_t, uint64_t>, EdgeSnapshot> snapshots;        // the counters seen by the previous rebalance
+    std::function<void(const ColocationReport &)> reporter;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running;
+
+public:
+    void setMinimumMessages(uint64_t _minimumMessages){
+        // the calls per period (in both directions) needed to co-locate a pair of objects; like setReporter(), it can be called
+        // while the policy is running, but not by the reporter itself (the internal thread holds the mutex while reporting)
+        std::lock_guard<std::mutex> lock(mutex);
+        minimumMessages = _minimumMessages;
+    }
+    void setReporter(const std::function<void(const ColocationReport &)> &_reporter){
+        std::lock_guard<std::mutex> lock(mutex);
+        reporter = _reporter;
+    }
+    void start(int intervalMsecs){
+        stop();
+        TrafficNode::setTrackingEnabled(true);
+        running = true;
+        thread = std::thread([this, intervalMsecs](){
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!condition.wait_for(lock, std::chrono::milliseconds(intervalMsecs), [this](){ return !running; })){
+                ColocationReport report = rebalance();
+                if(reporter){
+                    reporter(report);
+                }
+            }
+        });
+    }
+    void stop(){
+        // the current placement is kept, and the tracking stays enabled
+        if(thread.joinable()){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+            condition.notify_all();
+            thread.join();
+        }
+    }
+    ColocationReport rebalance(){
+        std::lock_guard<std::mutex> lock(TrafficNode::registryMutex());
+        const std::vector<TrafficNode*> &nodes = TrafficNode::registry();
+        std::map<uint64_t, int> indexOf;
+        for(size_t i = 0; i < nodes.size(); i++){
+            if(nodes[i]->threadId_.load()){
+                indexOf[nodes[i]->id_] = (int)i;
+            }
+        }
+        ColocationReport report;
+#if defined(__linux__)
+        report.supported = true;
+#else
+        report.supported = false;
+#endif
+        report.domains = topology.domainCount();
+        report.messages = 0;
+        report.localMessages = 0;
+        // the calls of the period, as undirected weighted pairs
+        std::map<std::pair<int, int>, uint64_t> pairs;
+        std::map<std::pair<uint64_t, uint64_t>, EdgeSnapshot> currentSnapshots;
+        for(std::map<uint64_t, int>::const_iterator sender = indexOf.begin(); sender != indexOf.end(); ++sender){
+            TrafficNode *node = nodes[sender->second];
+            TrafficNode::Edge *table = node->edges.load(std::memory_order_acquire);
+            if(!table){
+                continue;
+            }
+            uint64_t epoch = node->epoch.load(std::memory_order_acquire);
+            for(int e = 0; e < TrafficNode::edgeCount; e++){
+                uint64_t receiver = table[e].receiver.load(std::memory_order_relaxed);
+                std::map<uint64_t, int>::const_iterator found = indexOf.find(receiver);
+                if(found == indexOf.end()){
+                    continue;           // a free entry, or a receiver already deleted
+                }
+                EdgeSnapshot current = {epoch, table[e].messages.load(std::memory_order_relaxed), table[e].localMessages.load(std::memory_order_relaxed)};
+                std::pair<uint64_t, uint64_t> key(sender->first, receiver);
+                currentSnapshots[key] = current;
+                uint64_t messages = current.messages;
+                uint64_t localMessages = current.localMessages;
+                std::map<std::pair<uint64_t, uint64_t>, EdgeSnapshot>::const_iterator previous = snapshots.find(key);
+                if(previous != snapshots.end() && previous->second.epoch == epoch && previous->second.messages <= messages){
+                    messages -= previous->second.messages;
+                    localMessages -= std::min(localMessages, previous->second.localMessages);
+                }
+                report.messages += messages;
+                report.localMessages += std::min(localMessages, messages);
+                if(messages){
+                    pairs[std::make_pair(std::min(sender->second, found->second), std::max(sender->second, found->second))] += messages;
+                }
+            }
+        }
+        snapshots.swap(currentSnapshots);
+        report.locality = report.messages ? (double)report.localMessages / report.messages : -1;
+        report.previousLocality = previousLocality;
+        previousLocality = report.locality;
+#if defined(__linux__)
+        place(nodes, pairs, report);
+#endif
+        return report;
+    }
+
+#if defined(__linux__)
+private:
+    struct Group {
+        std::vector<int> members;
+        int anchor;                 // the domain of a member with a fixed affinity, -1 if none
+        uint64_t messages;
+    };
+
+private:
+    void place(const std::vector<TrafficNode*> &nodes, const std::map<std::pair<int, int>, uint64_t> &pairs, ColocationReport &report){
+        // the nodes with an affinity fixed by the user (anchor >= 0 when the affinity is inside a single domain)
+        std::vector<bool> fixed(nodes.size(), false);
+        std::vector<int> anchors(nodes.size(), -1);
+        for(size_t i = 0; i < nodes.size(); i++){
+            long threadId = nodes[i]->threadId_.load();
+            cpu_set_t affinity;
+            CPU_ZERO(&affinity);
+            if(!threadId || sched_getaffinity((pid_t)threadId, sizeof(affinity), &affinity) != 0){
+                continue;
+            }
+            bool changedByPolicy = nodes[i]->pinnedByPolicy && CPU_EQUAL(&affinity, &nodes[i]->policyAffinity);
+            if(!changedByPolicy && !CPU_EQUAL(&affinity, &nodes[i]->initialAffinity)){
+                fixed[i] = true;
+                anchors[i] = singleDomain(affinity);
+            }
+        }
+        // the groups, joining the heaviest pairs first
+        std::vector<std::pair<uint64_t, std::pair<int, int> > > heavyPairs;
+        for(std::map<std::pair<int, int>, uint64_t>::const_iterator pair = pairs.begin(); pair != pairs.end(); ++pair){
+            if(pair->second >= minimumMessages){
+                heavyPairs.push_back(std::make_pair(pair->second, pair->first));
+            }
+        }
+        std::sort(heavyPairs.rbegin(), heavyPairs.rend());
+        size_t largestDomain = 0;
+        for(int d = 0; d < topology.domainCount(); d++){
+            largestDomain = std::max(largestDomain, topology.cpus(d).size());
+        }
+        std::vector<int> groupOf(nodes.size(), -1);
+        std::vector<Group> groups;
+        for(size_t p = 0; p < heavyPairs.size(); p++){
+            int a = heavyPairs[p].second.first;
+            int b = heavyPairs[p].second.second;
+            if((fixed[a] && anchors[a] < 0) || (fixed[b] && anchors[b] < 0)){
+                continue;           // a fixed affinity across several domains cannot be an anchor
+            }
+            if(groupOf[a] < 0){
+                std::swap(a, b);
+            }
+            if(groupOf[a] < 0){
+                Group group;
+                group.members.push_back(a);
+                group.members.push_back(b);
+                group.anchor = fixed[a] ? anchors[a] : anchors[b];
+                group.messages = heavyPairs[p].first;
+                if((fixed[a] && fixed[b] && anchors[a] != anchors[b]) || group.members.size() > largestDomain){
+                    continue;
+                }
+                groupOf[a] = groupOf[b] = (int)groups.size();
+                groups.push_back(group);
+            }
+            else if(groupOf[b] < 0){
+                Group &group = groups[groupOf[a]];
+                if((fixed[b] && group.anchor >= 0 && group.anchor != anchors[b]) || group.members.size() + 1 > largestDomain){
+                    continue;
+                }
+                if(fixed[b]){
+                    group.anchor = anchors[b];
+                }
+                group.members.push_back(b);
+                group.messages += heavyPairs[p].first;
+                groupOf[b] = groupOf[a];
+            }
+            else if(groupOf[a] != groupOf[b]){
+                Group &group = groups[groupOf[a]];
+                Group &other = groups[groupOf[b]];
+                if((group.anchor >= 0 && other.anchor >= 0 && group.anchor != other.anchor) ||
+                   group.members.size() + other.members.size() > largestDomain){
+                    continue;
+                }
+                if(group.anchor < 0){
+                    group.anchor = other.anchor;
+                }
+                for(size_t m = 0; m < other.members.size(); m++){
+                    groupOf[other.members[m]] = groupOf[a];
+                    group.members.push_back(other.members[m]);
+                }
+                group.messages += other.messages + heavyPairs[p].first;
+                other.members.clear();
+            }
+            else{
+                groups[groupOf[a]].messages += heavyPairs[p].first;
+            }
+        }
+        // the domains of the groups, the heaviest groups first
+        std::vector<int> order;
+        for(size_t g = 0; g < groups.size(); g++){
+            if(!groups[g].members.empty()){
+                order.push_back((int)g);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&groups](int a, int b){ return groups[a].messages > groups[b].messages; });
+        std::vector<size_t> freeCpus(topology.domainCount());
+        for(int d = 0; d < topology.domainCount(); d++){
+            freeCpus[d] = topology.cpus(d).size();
+        }
+        std::vector<bool> placed(nodes.size(), false);
+        for(size_t o = 0; o < order.size(); o++){
+            Group &group = groups[order[o]];
+            int target = group.anchor;
+            if(target >= 0 && freeCpus[target] < group.members.size()){
+                continue;               // the domain of its fixed member is already full, it would be oversubscribed
+            }
+            if(target < 0){
+                std::vector<int> votes(topology.domainCount(), 0);
+                for(size_t m = 0; m < group.members.size(); m++){
+                    int domain = nodes[group.members[m]]->domain.load(std::memory_order_relaxed);
+                    if(domain >= 0 && domain < topology.domainCount()){
+                        votes[domain]++;
+                    }
+                }
+                for(int d = 0; d < topology.domainCount(); d++){
+                    if(freeCpus[d] >= group.members.size() &&
+                       (target < 0 || votes[d] > votes[target] || (votes[d] == votes[target] && freeCpus[d] > freeCpus[target]))){
+                        target = d;
+                    }
+                }
+                if(target < 0){
+                    continue;           // no domain has enough free cpus left
+                }
+            }
+            freeCpus[target] -= std::min(freeCpus[target], group.members.size());
+            for(size_t m = 0; m < group.members.size(); m++){
+                int member = group.members[m];
+                TrafficNode *node = nodes[member];
+                ColocationDecision decision = {ColocationDecision::Pinned, node->id_, node->threadId_.load(), target, group.messages};
+                if(fixed[member]){
+                    decision.action = ColocationDecision::KeptFixed;
+                    report.decisions.push_back(decision);
+                    continue;
+                }
+                cpu_set_t affinity;
+                CPU_ZERO(&affinity);
+                const std::vector<int> &cpus = topology.cpus(target);
+                for(size_t c = 0; c < cpus.size(); c++){
+                    if(CPU_ISSET(cpus[c], &node->initialAffinity)){
+                        CPU_SET(cpus[c], &affinity);        // the cpus allowed to the process only
+                    }
+                }
+                if(CPU_COUNT(&affinity) == 0){
+                    continue;
+                }
+                placed[member] = true;
+                if(node->pinnedByPolicy && CPU_EQUAL(&affinity, &node->policyAffinity)){
+                    continue;           // already there
+                }
+                if(sched_setaffinity((pid_t)decision.threadId, sizeof(affinity), &affinity) == 0){
+                    node->policyAffinity = affinity;
+                    node->pinnedByPolicy = true;
+                    report.decisions.push_back(decision);
+                }
+                else{
+                    placed[member] = node->pinnedByPolicy;
+                }
+            }
+        }
+        // the threads pinned before, and not in a group anymore, get back their original affinity
+        for(size_t i = 0; i < nodes.size(); i++){
+            TrafficNode *node = nodes[i];
+            if(fixed[i]){
+                node->pinnedByPolicy = false;           // the user has changed it, so it is not ours anymore
+                continue;
+            }
+            if(!node->pinnedByPolicy || placed[i]){
+                continue;
+            }
+            long threadId = node->threadId_.load();
+            if(threadId && sched_setaffinity((pid_t)threadId, sizeof(node->initialAffinity), &node->initialAffinity) == 0){
+                ColocationDecision decision = {ColocationDecision::Released, node->id_, threadId, -1, 0};
+                report.decisions.push_back(decision);
+            }
+            node->pinnedByPolicy = false;
+        }
+    }
+    int singleDomain(const cpu_set_t &affinity) const {
+        int domain = -1;
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            if(CPU_ISSET(cpu, &affinity)){
+                int cpuDomain = topology.domainOf(cpu);
+                if(domain >= 0 && cpuDomain != domain){
+                    return -1;
+                }
+                domain = cpuDomain;
+            }
+        }
+        return domain;
+    }
+#endif
+
+private:
+    ColocationPolicy(const ColocationPolicy &);
+    ColocationPolicy &operator=(const ColocationPolicy &);
+
+};
+
+
+#endif // COLOCATIONPOLICY_H
@@ -0,0 +1,85 @@
+/*
+
+    The futexWait and futexWake functions are the minimal wait/wake primitives used by the Qt-free classes (StdEventLoop,
+    StdSemaphore, ...): futexWait blocks while the value of the atomic integer is equal to the expected one (at most for
+    timeout milliseconds if timeout is not negative), futexWake wakes up to count threads blocked on the atomic integer.
+    futexWaitShared and futexWakeShared are the same, for an atomic integer in a memory shared between processes (ProcessWrapperX).
+
+    On Linux they are the futex system calls, so a wake without waiters costs only the system call; on the other systems
+    they fall back to a short sleep polling loop.
+
+*/
+
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+inline void futexSystemWait(std::atomic<int> *address, int expected, int timeout, bool shared){
+#if defined(__linux__)
+    struct timespec timeSpec;
+    struct timespec *timeSpecPointer = 0;
+    if(timeout >= 0){
+        timeSpec.tv_sec = timeout / 1000;
+        timeSpec.tv_nsec = (long)(timeout % 1000) * 1000000L;
+        timeSpecPointer = &timeSpec;
+    }
+    syscall(SYS_futex, reinterpret_cast<int*>(address), shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, timeSpecPointer, 0, 0);
+#else
+    (void)shared;
+    std::chrono::steady_clock::time_point limit = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    while(address->load() == expected){
+        if(timeout >= 0 && std::chrono::steady_clock::now() >= limit){
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+}
+
+
+inline void futexSystemWake(std::atomic<int> *address, int count, bool shared){
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<int*>(address), shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+#else
+    (void)address;
+    (void)count;
+    (void)shared;
+#endif
+}
+
+
+inline void futexWait(std::atomic<int> *address, int expected, int timeout = -1){
+    futexSystemWait(address, expected, timeout, false);
+}
+
+
+inline void futexWake(std::atomic<int> *address, int count = INT_MAX){
+    futexSystemWake(address, count, false);
+}
+
+
+inline void futexWaitShared(std::atomic<int> *address, int expected, int timeout = -1){
+    // the atomic integer is in a memory shared between processes
+    futexSystemWait(address, expected, timeout, true);
+}
+
+
+inline void futexWakeShared(std::atomic<int> *address, int count = INT_MAX){
+    futexSystemWake(address, count, true);
+}
+
+
+#endif // FUTEX_H
@@ -0,0 +1,146 @@
+#include "inboxobject.h"
+#include <QThread>
+
+
+class InboxWakeEvent : public QEvent, public RecyclingAllocated
+{
+
+public:
+    InboxWakeEvent(QEvent::Type type, bool _urgent) :
+      QEvent(type){
+        urgent = _urgent;
+    }
+
+public:
+    bool urgent;
+
+};
+
+
+
+InboxObject::InboxObject(QObject *parent) :
+    QObject(parent)
+{
+
+    scheduled.store(false);
+    urgentScheduled.store(false);
+    objectT = 0;
+    deletionPosted = false;
+    trafficNode.attachCurrentThread();
+
+}
+
+
+
+InboxObject::~InboxObject(){
+
+    // the calls never executed are discarded
+    CallEnvelope *envelope;
+    while((envelope = lanes.next()) != 0 || !lanes.isEmpty()){
+        if(envelope){
+            envelope->discard();
+        }
+    }
+
+}
+
+
+void InboxObject::postEnvelope(CallEnvelope *envelope, CallLane lane){
+
+    trafficNode.recordPost();
+    lanes.push(envelope, lane);
+    if(lane == UrgentLane){
+        if(!urgentScheduled.exchange(true)){
+            scheduleWake(true);
+        }
+    }
+    else if(!scheduled.exchange(true)){
+        scheduleWake(false);
+    }
+
+}
+
+
+void InboxObject::setObjectT(QObject *_objectT){
+
+    objectT = _objectT;
+    // the object and the inbox are in the same thread, so the direct connection clears the pointer during the deletion of the object
+    connect(objectT, &QObject::destroyed, this, [this](){
+        objectT = 0;
+        trafficNode.detachCurrentThread();          // the thread is ending, so the ColocationPolicy must not pin it anymore
+    }, Qt::DirectConnection);
+
+}
+
+
+void InboxObject::postDeletion(){
+
+    post([this](){
+        // like objectT->deleteLater() (so it is safe inside a nested event loop of T), but ahead of the events pending for the thread
+        deletionPosted = true;
+        QCoreApplication::postEvent(objectT, new QDeferredDeleteEvent(), Qt::HighEventPriority);
+    }, UrgentLane);
+
+}
+
+
+bool InboxObject::event(QEvent *event){
+
+    if(event->type() != wakeEventType()){
+        return QObject::event(event);
+    }
+    // from now on, a new call needs a new wake event; a wake event executes the calls of both the lanes
+    if(static_cast<InboxWakeEvent*>(event)->urgent){
+        urgentScheduled.store(false);
+    }
+    else{
+        scheduled.store(false);
+    }
+    trafficNode.sampleDomain();
+    int executed = 0;
+    int retries = 0;
+    while(executed < 256 && !deletionPosted){       // after a long burst we let the other events of the thread run
+        CallEnvelope *envelope = lanes.next();
+        if(!envelope){
+            if(lanes.isEmpty() || ++retries > 16){
+                break;                  // if the producer has been preempted in its push(), we come back with the wake event below
+            }
+            QThread::yieldCurrentThread();      // a producer is completing its push()
+            continue;
+        }
+        if(objectT){
+            envelope->run();
+            envelope->release();
+        }
+        else{
+            envelope->discard();        // the object T has been deleted
+        }
+        executed++;
+    }
+    if(!deletionPosted){                // otherwise the calls left are discarded with the inbox
+        if(lanes.hasUrgent() && !urgentScheduled.exchange(true)){
+            scheduleWake(true);
+        }
+        if(!lanes.isEmpty() && !scheduled.exchange(true)){
+            scheduleWake(false);
+        }
+    }
+    RecyclingPool::flush();             // we give back the envelopes of the other threads
+    return true;
+
+}
+
+
+void InboxObject::scheduleWake(bool urgent){
+
+    QCoreApplication::postEvent(this, new InboxWakeEvent(wakeEventType(), urgent), urgent ? Qt::HighEventPriority : Qt::NormalEventPriority);
+
+}
+
+
+QEvent::Type InboxObject::wakeEventType(){
+
+    static const QEvent::Type type = static_cast<QEvent::Type>(QEvent::registerEventType());
+    return type;
+
+}
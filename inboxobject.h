@@ -0,0 +1,64 @@
+/*
+
+    This class is the inbox of the calls posted to the object of the QObject derived class T inside the QThread (by post() and
+    invokeSync() of the ThreadWrapperX classes).
+    The calls are CallEnvelope objects, pushed in the lock-free CallLanes (a bulk lane and an urgent lane), and a single (pooled)
+    wake event is posted to the inbox for a whole burst of calls, so the QMetaCallEvent and the argument copies of
+    QMetaObject::invokeMethod are not allocated for every call. The wake event of the urgent lane is posted with
+    Qt::HighEventPriority, so the urgent calls overtake also the other events pending for the thread.
+    The deletion of the object T is requested by postDeletion(), through the urgent lane: its DeferredDelete event is posted with
+    Qt::HighEventPriority, and from then on the inbox does not execute any call, so the deletion does not wait for the pending
+    calls. When the object T is deleted, the calls still in the inbox are discarded.
+    The inbox is created inside the thread, so its TrafficNode (trafficnode.h) is attached to the thread in the constructor.
+    To better understand the meaning, refer to the code of the "ThreadWrapper" and "ThreadObject" classes.
+
+*/
+
+
+#ifndef INBOXOBJECT_H
+#define INBOXOBJECT_H
+
+#include <atomic>
+#include <QObject>
+#include <QEvent>
+#include <QCoreApplication>
+#include "callenvelope.h"
+#include "recyclingpool.h"
+#include "trafficnode.h"
+
+class InboxObject : public QObject, public RecyclingAllocated
+{
+    Q_OBJECT
+public:
+    explicit InboxObject(QObject *parent = 0);
+    ~InboxObject();
+
+public:
+    TrafficNode trafficNode;
+
+private:
+    CallLanes lanes;
+    std::atomic<bool> scheduled;        // true if a wake event is pending
+    std::atomic<bool> urgentScheduled;  // true if a high priority wake event is pending
+    QObject *objectT;
+    bool deletionPosted;                // true once the DeferredDelete event of objectT has been posted
+
+public:
+    void postEnvelope(CallEnvelope *envelope, CallLane lane = BulkLane);
+    template <class Functor>
+    void post(Functor functor, CallLane lane = BulkLane){
+        postEnvelope(new FunctorCallEnvelope<Functor>(functor), lane);
+    }
+    void setObjectT(QObject *_objectT);
+    void postDeletion();
+
+protected:
+    bool event(QEvent *event);
+
+private:
+    void scheduleWake(bool urgent);
+    static QEvent::Type wakeEventType();
+
+};
+
+#endif // INBOXOBJECT_H
@@ -0,0 +1,93 @@
+/*
+
+    The MpscQueue class is an intrusive lock-free queue with many producers and a single consumer (the algorithm of Dmitry Vyukov):
+    push() costs a single atomic exchange and can be called from any thread, while pop() must be called only by the consumer thread.
+    The queued objects must derive from MpscNode, and they are not owned by the queue.
+
+    pop() returns 0 when the queue is empty, but also in the (very short) window in which a producer has started a push() and not
+    completed it yet: in this case isEmpty() is false and the consumer simply tries again.
+
+*/
+
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+
+
+class MpscNode
+{
+
+public:
+    MpscNode(){
+        next.store(0, std::memory_order_relaxed);
+    }
+
+public:
+    std::atomic<MpscNode*> next;
+
+};
+
+
+class MpscQueue
+{
+
+public:
+    MpscQueue(){
+        head.store(&stub);
+        tail = &stub;
+    }
+
+private:
+    std::atomic<MpscNode*> head;        // the last pushed node, modified by the producers
+    MpscNode *tail;                     // the next node to pop, modified only by the consumer
+    MpscNode stub;
+
+public:
+    void push(MpscNode *node){
+        node->next.store(0, std::memory_order_relaxed);
+        MpscNode *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+    MpscNode *pop(){
+        MpscNode *first = tail;
+        MpscNode *next = first->next.load(std::memory_order_acquire);
+        if(first == &stub){
+            if(!next){
+                return 0;
+            }
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if(next){
+            tail = next;
+            return first;
+        }
+        if(first != head.load(std::memory_order_acquire)){
+            return 0;           // a producer is in the middle of a push()
+        }
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if(next){
+            tail = next;
+            return first;
+        }
+        return 0;
+    }
+    bool isEmpty() const {
+        if(tail != &stub){
+            return false;           // the tail is a node not popped yet
+        }
+        return stub.next.load(std::memory_order_acquire) == 0 && head.load(std::memory_order_acquire) == &stub;
+    }
+
+private:
+    MpscQueue(const MpscQueue &);
+    MpscQueue &operator=(const MpscQueue &);
+
+};
+
+
+#endif // MPSCQUEUE_H
@@ -0,0 +1,1109 @@
+/*
+
+    The ProcessWrapperX classes are the cross-process version of the ThreadWrapperX classes: the object of the class T is constructed
+    (and lives) in a child process, for isolation, while the wrapper stays in the parent process.
+    They keep the same semantics: the constructor of the wrapper returns only after the creation of the object T in the child, and
+    the destructor only after the deletion of the object T and the end of the child; as for the threads, we have 8 classes, from
+    ProcessWrapper0 (no arguments for the constructor of T) to ProcessWrapper7 (7 arguments):
+        ProcessWrapper2<Worker,int,double> *processWrapperObject;
+        processWrapperObject = new ProcessWrapper2<Worker,int,double>(arg1,arg2);
+        processWrapperObject->post([](Worker *worker){ worker->doStuff(); });
+        ....... do stuff .....
+        delete processWrapperObject;
+
+    The children are forked (without exec) by a zygote, a helper process forked only once, so the code and the static data have
+    the same addresses in all the processes. The calls are sent through a ring buffer (ProcessChannel) in a memory shared by the
+    two processes, with a futex wakeup paid only when the child is sleeping: the socket of the zygote is used only for the creation,
+    and the callable (with its captured values) is copied byte by byte in the ring, so it must be trivially copyable (no pointers or
+    references to the memory of the parent, no std::string, ...) and not larger than ProcessChannel::payloadSize bytes. In the same
+    way the arguments of the constructor are copied byte by byte to the zygote, so they must be trivially copyable too (at most 256
+    bytes in total).
+    invokeSync() waits for the completion of the call (spinning for a few microseconds, then sleeping on the futex) and, with the
+    second form, it copies back the result of the callable (trivially copyable too):
+        int count;
+        processWrapperObject->invokeSync([](Worker *worker){ return worker->count(); }, &count);
+    If the child has ended (for example after a crash), post() and invokeSync() return false, and isRunning() is false.
+
+    A fork without exec is safe only while the process has a single thread (a lock held by another thread at the time of the fork
+    would be held forever in the child), so the children are not forked by the parent, which can have any number of threads, but
+    by the zygote (ProcessZygote), which is single-threaded. The zygote should be started at the start of main(), before any other
+    thread (a ThreadWrapperX, a thread pool, ...) is started:
+        int main(int argc, char *argv[]){
+            ProcessZygote::start();
+            ....... create the threads and the wrappers, from any thread .....
+        }
+    otherwise it is started by the first wrapper, with the same constraint. The object T sees the static data as they were when the
+    zygote was started, not the current ones of the parent. The object T must be fork-safe: it must not rely on the other threads
+    of the parent (and on QThread or the Qt event loop), and it must not use a ThreadWrapperX or the ColocationPolicy inside the
+    child.
+    The constructor of the wrapper throws std::system_error if the shared memory, the zygote or the child cannot be created, and
+    std::runtime_error if the object T cannot be created in the child (its constructor throws, or the child ends).
+    The zygote ends with the parent, and the child watches the zygote while it is idle, so it deletes the object T and ends within
+    about 200 milliseconds after the end of the parent. The shared memory is about 33 KB, and the memory of the zygote is shared
+    with the child until it is written (copy on write).
+
+*/
+
+
+#ifndef PROCESSWRAPPER_H
+#define PROCESSWRAPPER_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "futex.h"
+
+
+class ProcessChannel
+{
+
+    // it lives in the shared memory, so it contains only lock-free atomics and plain data
+
+public:
+    enum State {Starting, Ready, Failed};
+    enum Kind {Call, SyncCall};
+    enum ReplyState {Idle, Posted, Parked, Done};
+    enum {slotCount = 256, payloadSize = 104};
+
+    struct alignas(64) Slot {
+        unsigned char payload[payloadSize];             // the bytes of the callable, at the beginning of the slot for the alignment
+        void (*invoker)(void *payload, void *object, void *result);
+        std::atomic<uint64_t> sequence;                 // the algorithm of the bounded queue of Dmitry Vyukov
+        uint32_t kind;
+        uint32_t size;
+    };
+    struct Reply {
+        std::atomic<int> state;
+        unsigned char result[payloadSize];
+    };
+
+public:
+    ProcessChannel(){
+        state.store(Starting);
+        stopRequested.store(0);
+        exited.store(0);
+        stopped.store(0);
+        sleeping.store(0);
+        spaceEpoch.store(0);
+        waitingProducers.store(0);
+        enqueuePosition.store(0);
+        dequeuePosition = 0;
+        reply.state.store(Idle);
+        for(int i = 0; i < slotCount; i++){
+            slots[i].sequence.store(i);
+        }
+    }
+
+public:
+    std::atomic<int> state;
+    std::atomic<int> stopRequested;
+    std::atomic<int> exited;                    // set by the zygote when the child has ended
+    std::atomic<int> stopped;                   // set by the child just before its end, after the deletion of the object T
+    std::atomic<int> sleeping;                  // 1 while the child is (or is going to be) blocked on the futex
+    std::atomic<int> spaceEpoch;                // incremented by the child when it frees slots for the waiting producers
+    std::atomic<int> waitingProducers;
+    Reply reply;                                // used by one invokeSync() at a time
+
+private:
+    alignas(64) std::atomic<uint64_t> enqueuePosition;
+    alignas(64) uint64_t dequeuePosition;       // used only by the child
+    Slot slots[slotCount];
+
+public:
+    bool push(void (*invoker)(void *, void *, void *), Kind kind, const void *payload, uint32_t size){
+        // called by the threads of the parent; it returns false if the ring is full
+        uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        for(;;){
+            slot = &slots[position & (slotCount - 1)];
+            int64_t difference = (int64_t)(slot->sequence.load(std::memory_order_acquire) - position);
+            if(difference == 0){
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if(difference < 0){
+                return false;
+            }
+            else{
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        std::memcpy(slot->payload, payload, size);
+        slot->invoker = invoker;
+        slot->kind = kind;
+        slot->size = size;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    Slot *front(){
+        // called only by the child; it returns 0 if there is no call ready
+        Slot *slot = &slots[dequeuePosition & (slotCount - 1)];
+        return slot->sequence.load(std::memory_order_acquire) == dequeuePosition + 1 ? slot : 0;
+    }
+    void pop(){
+        // called only by the child, after the call in front() has been executed
+        slots[dequeuePosition & (slotCount - 1)].sequence.store(dequeuePosition + slotCount, std::memory_order_release);
+        dequeuePosition++;
+    }
+    bool isEmpty() const {
+        return enqueuePosition.load(std::memory_order_acquire) == dequeuePosition;
+    }
+
+private:
+    ProcessChannel(const ProcessChannel &);
+    ProcessChannel &operator=(const ProcessChannel &);
+
+};
+
+
+class ProcessZygote
+{
+
+    // the helper process which forks the children of the ProcessWrapperX classes: it is forked only once, by start() or by the
+    // first wrapper, so the children are forks of its image (single-threaded) even if the wrappers are created later by any thread
+    // of a multi-threaded process. The requests are sent through a socket, with the file descriptor of the shared memory of the
+    // channel and the bytes of the factory of the object T; the zygote reaps its children, and it sets ProcessChannel::exited
+    // when one of them has ended. It ends with the process (the socket is closed), and then its children end too.
+
+public:
+    typedef void (*ChildMain)(ProcessChannel *channel, const void *factory, pid_t zygote);
+    enum {factorySize = 256};
+
+public:
+    static void start(){
+        // to be called at the start of main(), before any other thread is started; it throws std::system_error on failure
+        ProcessZygote &zygote = instance();
+        std::lock_guard<std::mutex> lock(zygote.mutex);
+        zygote.startZygote();
+    }
+    static bool isRunning(){
+        ProcessZygote &zygote = instance();
+        std::lock_guard<std::mutex> lock(zygote.mutex);
+        return zygote.checkZygote();
+    }
+    static pid_t forkChild(int memory, ChildMain childMain, const void *factory, size_t size){
+        // called by the wrappers; it returns the pid of the child, or it throws std::system_error
+        ProcessZygote &zygote = instance();
+        std::lock_guard<std::mutex> lock(zygote.mutex);
+        zygote.startZygote();
+        Request request;
+        std::memset(&request, 0, sizeof(request));
+        std::memcpy(request.factory, factory, size);
+        request.childMain = childMain;
+        Reply reply;
+        errno = 0;
+        if(!sendRequest(zygote.socket, request, memory) || !receiveAll(zygote.socket, &reply, sizeof(reply))){
+            int error = errno ? errno : EPIPE;
+            zygote.checkZygote();
+            throw std::system_error(error, std::system_category(), "ProcessWrapper: zygote");
+        }
+        if(reply.error){
+            throw std::system_error(reply.error, std::system_category(), "ProcessWrapper: fork");
+        }
+        return reply.pid;
+    }
+
+private:
+    struct Request {
+        alignas(16) unsigned char factory[factorySize];
+        ChildMain childMain;
+    };
+    struct Reply {
+        pid_t pid;
+        int error;
+    };
+
+private:
+    ProcessZygote(){
+        pid = -1;
+        socket = -1;
+    }
+    ~ProcessZygote(){
+        // the zygote ends when its socket is closed
+        if(socket >= 0){
+            close(socket);
+        }
+        if(pid > 0){
+            int status;
+            while(waitpid(pid, &status, 0) < 0 && errno == EINTR){
+            }
+        }
+    }
+
+private:
+    std::mutex mutex;
+    pid_t pid;
+    int socket;
+
+private:
+    static ProcessZygote &instance(){
+        static ProcessZygote zygote;
+        return zygote;
+    }
+    void startZygote(){
+        if(checkZygote()){
+            return;
+        }
+        int sockets[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0){
+            throw std::system_error(errno, std::system_category(), "ProcessWrapper: socketpair");
+        }
+        fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+        pid_t parent = getpid();
+        pid_t zygote = fork();
+        if(zygote == 0){
+            close(sockets[0]);
+            serve(sockets[1], parent);
+            _exit(0);           // the atexit handlers and the static objects belong to the parent
+        }
+        close(sockets[1]);
+        if(zygote < 0){
+            int error = errno;
+            close(sockets[0]);
+            throw std::system_error(error, std::system_category(), "ProcessWrapper: fork");
+        }
+        pid = zygote;
+        socket = sockets[0];
+    }
+    bool checkZygote(){
+        if(pid <= 0){
+            return false;
+        }
+        int status;
+        pid_t waited = waitpid(pid, &status, WNOHANG);
+        if(waited == pid || (waited < 0 && errno == ECHILD)){
+            close(socket);          // the zygote has ended (for example it has been killed), so a new one is needed
+            socket = -1;
+            pid = -1;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static int *childEndedPipe(){
+        static int pipeEnds[2] = {-1, -1};
+        return pipeEnds;
+    }
+    static void childEnded(int){
+        int savedErrno = errno;
+        ssize_t written = write(childEndedPipe()[1], "", 1);          // it wakes the poll() of serve()
+        (void)written;
+        errno = savedErrno;
+    }
+    static void serve(int socket, pid_t parent){
+        // the loop of the zygote: it ends when the parent closes the socket, or when the parent has ended
+        int *pipeEnds = childEndedPipe();
+        if(pipe(pipeEnds) < 0){
+            return;
+        }
+        for(int i = 0; i < 2; i++){
+            fcntl(pipeEnds[i], F_SETFL, fcntl(pipeEnds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(pipeEnds[i], F_SETFD, FD_CLOEXEC);
+        }
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = &ProcessZygote::childEnded;
+        action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGCHLD, &action, 0);
+        std::vector<std::pair<pid_t, ProcessChannel*> > children;
+        for(;;){
+            struct pollfd descriptors[2];
+            descriptors[0].fd = socket;
+            descriptors[0].events = POLLIN;
+            descriptors[0].revents = 0;
+            descriptors[1].fd = pipeEnds[0];
+            descriptors[1].events = POLLIN;
+            descriptors[1].revents = 0;
+            int ready = poll(descriptors, 2, 200);
+            if(ready < 0 && errno != EINTR){
+                break;
+            }
+            char drained[64];
+            while(read(pipeEnds[0], drained, sizeof(drained)) > 0){
+            }
+            reap(children);
+            if(getppid() != parent){
+                break;
+            }
+            if(ready <= 0 || !descriptors[0].revents){
+                continue;
+            }
+            Request request;
+            int memory = -1;
+            if(!receiveRequest(socket, &request, &memory)){
+                break;          // the parent has closed the socket
+            }
+            Reply reply;
+            reply.pid = -1;
+            reply.error = 0;
+            void *address = mmap(0, sizeof(ProcessChannel), PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+            close(memory);
+            if(address == MAP_FAILED){
+                reply.error = errno;
+            }
+            else{
+                ProcessChannel *channel = static_cast<ProcessChannel*>(address);
+                pid_t child = fork();
+                if(child == 0){
+                    close(socket);
+                    close(pipeEnds[0]);
+                    close(pipeEnds[1]);
+                    signal(SIGCHLD, SIG_DFL);
+                    request.childMain(channel, request.factory, getppid());        // it never returns
+                }
+                if(child < 0){
+                    reply.error = errno;
+                    munmap(address, sizeof(ProcessChannel));
+                }
+                else{
+                    reply.pid = child;
+                    children.push_back(std::make_pair(child, channel));
+                }
+            }
+            if(!sendAll(socket, &reply, sizeof(reply))){
+                break;
+            }
+        }
+    }
+    static void reap(std::vector<std::pair<pid_t, ProcessChannel*> > &children){
+        int status;
+        pid_t child;
+        while((child = waitpid(-1, &status, WNOHANG)) > 0){
+            for(size_t i = 0; i < children.size(); i++){
+                if(children[i].first == child){
+                    ProcessChannel *channel = children[i].second;
+                    channel->exited.store(1, std::memory_order_release);
+                    futexWakeShared(&channel->exited);
+                    munmap(channel, sizeof(ProcessChannel));
+                    children[i] = children.back();
+                    children.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+    static bool sendRequest(int socket, const Request &request, int memory){
+        // the file descriptor of the shared memory goes with the first byte of the request
+        char control[CMSG_SPACE(sizeof(int))];
+        std::memset(control, 0, sizeof(control));
+        struct iovec vector;
+        vector.iov_base = const_cast<Request*>(&request);
+        vector.iov_len = sizeof(Request);
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &memory, sizeof(int));
+        ssize_t sent;
+        while((sent = sendmsg(socket, &message, noSignal)) < 0 && errno == EINTR){
+        }
+        if(sent <= 0){
+            return false;
+        }
+        return sendAll(socket, reinterpret_cast<const char*>(&request) + sent, sizeof(Request) - sent);
+    }
+    static bool receiveRequest(int socket, Request *request, int *memory){
+        char control[CMSG_SPACE(sizeof(int))];
+        struct iovec vector;
+        vector.iov_base = request;
+        vector.iov_len = sizeof(Request);
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t received;
+        while((received = recvmsg(socket, &message, 0)) < 0 && errno == EINTR){
+        }
+        struct cmsghdr *header = received > 0 ? CMSG_FIRSTHDR(&message) : 0;
+        if(!header || header->cmsg_type != SCM_RIGHTS){
+            return false;
+        }
+        std::memcpy(memory, CMSG_DATA(header), sizeof(int));
+        if(!receiveAll(socket, reinterpret_cast<char*>(request) + received, sizeof(Request) - received)){
+            close(*memory);
+            return false;
+        }
+        return true;
+    }
+    static bool sendAll(int socket, const void *data, size_t size){
+        const char *bytes = static_cast<const char*>(data);
+        while(size > 0){
+            ssize_t sent = send(socket, bytes, size, noSignal);
+            if(sent < 0 && errno == EINTR){
+                continue;
+            }
+            if(sent <= 0){
+                return false;
+            }
+            bytes += sent;
+            size -= sent;
+        }
+        return true;
+    }
+    static bool receiveAll(int socket, void *data, size_t size){
+        char *bytes = static_cast<char*>(data);
+        while(size > 0){
+            ssize_t received = recv(socket, bytes, size, 0);
+            if(received < 0 && errno == EINTR){
+                continue;
+            }
+            if(received <= 0){
+                return false;
+            }
+            bytes += received;
+            size -= received;
+        }
+        return true;
+    }
+
+private:
+#if defined(MSG_NOSIGNAL)
+    enum {noSignal = MSG_NOSIGNAL};         // a zygote already ended must not kill the parent with SIGPIPE
+#else
+    enum {noSignal = 0};
+#endif
+
+private:
+    ProcessZygote(const ProcessZygote &);
+    ProcessZygote &operator=(const ProcessZygote &);
+
+};
+
+
+template <class T>
+class ProcessWrapper0
+{
+
+public:
+    ProcessWrapper0(){
+        initialize(true);
+    }
+
+protected:
+    explicit ProcessWrapper0(bool _enabled){
+        initialize(_enabled);
+    }
+
+private:
+    void initialize(bool _enabled){
+        channel = 0;
+        pid = -1;
+        enabled0 = _enabled;          // if there are arguments, it is obviously false
+        if(enabled0){
+            createProcess();
+        }
+    }
+
+public:
+    ~ProcessWrapper0(){
+        deleteProcess();            // for every X, as the object T lives in the child
+    }
+
+protected:
+    ProcessChannel *channel;
+    pid_t pid;
+    bool enabled0;
+    std::mutex callerMutex;         // the callers of invokeSync() share the reply of the channel
+
+protected:
+    void createProcess(){
+        startProcess([](){ return new T(); });
+    }
+    template <class Factory>
+    void startProcess(const Factory &factory){
+        // the factory is copied byte by byte to the zygote, which forks the child
+        static_assert(std::is_trivially_copyable<Factory>::value, "the arguments of T are copied byte by byte to the child process");
+        static_assert(sizeof(Factory) <= ProcessZygote::factorySize, "the arguments of T are too large for the child process");
+        static_assert(alignof(Factory) <= 16, "the arguments of T have a too strict alignment");
+        int memory = createSharedMemory(sizeof(ProcessChannel));
+        void *address = mmap(0, sizeof(ProcessChannel), PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+        if(address == MAP_FAILED){
+            int error = errno;
+            close(memory);
+            throw std::system_error(error, std::system_category(), "ProcessWrapper: mmap");
+        }
+        channel = new (address) ProcessChannel();
+        try{
+            pid = ProcessZygote::forkChild(memory, &runChild<Factory>, &factory, sizeof(factory));
+        }
+        catch(...){
+            close(memory);
+            deleteProcess();
+            throw;
+        }
+        close(memory);
+        // we wait the creation of the object T in the child (or the end of the child, if the creation fails)
+        while(channel->state.load(std::memory_order_acquire) == ProcessChannel::Starting){
+            futexWaitShared(&channel->state, ProcessChannel::Starting, 100);
+            if(channel->state.load(std::memory_order_acquire) == ProcessChannel::Starting && !isChildAlive()){
+                channel->state.store(ProcessChannel::Failed);
+            }
+        }
+        if(channel->state.load() != ProcessChannel::Ready){
+            deleteProcess();            // the child has ended, or it is ending
+            throw std::runtime_error("ProcessWrapper: the object could not be created in the child process");
+        }
+    }
+    void deleteProcess(){
+        if(!channel){
+            return;
+        }
+        if(pid > 0){
+            // the calls still in the ring are discarded, as the deletion of the object T goes before them
+            channel->stopRequested.store(1);
+            wakeChild();
+            while(!channel->exited.load(std::memory_order_acquire)){
+                futexWaitShared(&channel->exited, 0, 100);
+                if(!channel->exited.load(std::memory_order_acquire) && !ProcessZygote::isRunning()){
+                    // the zygote has ended, so nobody can tell us the end of the child, which is ending too (it watches its parent)
+                    while(!channel->stopped.load(std::memory_order_acquire) && kill(pid, 0) == 0){
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                    break;
+                }
+            }
+        }
+        channel->~ProcessChannel();
+        munmap(channel, sizeof(ProcessChannel));
+        channel = 0;
+        pid = -1;
+    }
+
+public:
+    bool isRunning(){
+        return channel && channel->state.load() == ProcessChannel::Ready && isChildAlive();
+    }
+    pid_t processId() const {return pid;}
+    template <class Functor>
+    bool post(Functor functor){
+        // the functor is called inside the child (with the object T as argument), after the calls already posted
+        checkCallable<Functor>();
+        return send(&invoke<Functor>, ProcessChannel::Call, &functor, sizeof(functor));
+    }
+    template <class Functor>
+    bool invokeSync(Functor functor){
+        checkCallable<Functor>();
+        return call(&invoke<Functor>, &functor, sizeof(functor), 0, 0);
+    }
+    template <class Functor, class Result>
+    bool invokeSync(Functor functor, Result *result){
+        checkCallable<Functor>();
+        static_assert(std::is_trivially_copyable<Result>::value, "the result of a process call is copied byte by byte");
+        static_assert(sizeof(Result) <= ProcessChannel::payloadSize, "the result of a process call is too large");
+        return call(&invokeWithResult<Functor, Result>, &functor, sizeof(functor), result, sizeof(Result));
+    }
+
+private:
+    bool send(void (*invoker)(void *, void *, void *), ProcessChannel::Kind kind, const void *payload, uint32_t size){
+        if(!channel || channel->state.load(std::memory_order_acquire) != ProcessChannel::Ready ||
+           channel->exited.load(std::memory_order_acquire)){
+            return false;
+        }
+        while(!channel->push(invoker, kind, payload, size)){
+            // the ring is full: we wait for the child to free some slots
+            int epoch = channel->spaceEpoch.load();
+            channel->waitingProducers.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool pushed = channel->push(invoker, kind, payload, size);
+            if(!pushed){
+                futexWaitShared(&channel->spaceEpoch, epoch, 100);
+            }
+            channel->waitingProducers.fetch_sub(1);
+            if(pushed){
+                break;
+            }
+            if(!isChildAlive()){
+                return false;
+            }
+        }
+        wakeChild();
+        return true;
+    }
+    bool call(void (*invoker)(void *, void *, void *), const void *payload, uint32_t size, void *result, size_t resultSize){
+        std::lock_guard<std::mutex> lock(callerMutex);
+        if(!channel){
+            return false;
+        }
+        ProcessChannel::Reply &reply = channel->reply;
+        reply.state.store(ProcessChannel::Posted, std::memory_order_relaxed);
+        if(!send(invoker, ProcessChannel::SyncCall, payload, size)){
+            reply.state.store(ProcessChannel::Idle, std::memory_order_relaxed);
+            return false;
+        }
+        static const bool spinning = std::thread::hardware_concurrency() > 1;        // spinning on a single cpu only delays the child
+        bool done = false;
+        if(spinning){
+            // a few microseconds, bounded by time as in SyncCallSlot::wait()
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(5);
+            for(int i = 1; !done; i++){
+                done = reply.state.load(std::memory_order_acquire) == ProcessChannel::Done;
+                if(!(i & 31) && std::chrono::steady_clock::now() >= deadline){
+                    break;
+                }
+            }
+        }
+        int expected = ProcessChannel::Posted;
+        if(!done && reply.state.compare_exchange_strong(expected, ProcessChannel::Parked, std::memory_order_acq_rel)){
+            while(reply.state.load(std::memory_order_acquire) != ProcessChannel::Done){
+                futexWaitShared(&reply.state, ProcessChannel::Parked, 100);
+                if(reply.state.load(std::memory_order_acquire) != ProcessChannel::Done && !isChildAlive()){
+                    reply.state.store(ProcessChannel::Idle, std::memory_order_relaxed);
+                    return false;           // the child has ended before executing the call
+                }
+            }
+        }
+        if(result){
+            std::memcpy(result, reply.result, resultSize);
+        }
+        reply.state.store(ProcessChannel::Idle, std::memory_order_relaxed);
+        return true;
+    }
+    void wakeChild(){
+        if(channel->sleeping.exchange(0) == 1){
+            futexWakeShared(&channel->sleeping, 1);
+        }
+    }
+    bool isChildAlive(){
+        if(!channel || pid <= 0 || channel->exited.load(std::memory_order_acquire)){
+            return false;
+        }
+        // the zygote tells us the end of the child; if the zygote itself has ended, the child is ending too
+        return ProcessZygote::isRunning() || kill(pid, 0) == 0;
+    }
+    static int createSharedMemory(size_t size){
+        // a file descriptor, so the memory can be sent to the zygote
+#if defined(__linux__)
+        int memory = memfd_create("processwrapper", MFD_CLOEXEC);
+#else
+        static std::atomic<unsigned> counter(0);
+        char name[64];
+        std::snprintf(name, sizeof(name), "/processwrapper-%d-%u", (int)getpid(), counter++);
+        int memory = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(memory >= 0){
+            shm_unlink(name);
+        }
+#endif
+        if(memory < 0){
+            throw std::system_error(errno, std::system_category(), "ProcessWrapper: shared memory");
+        }
+        if(ftruncate(memory, size) < 0){
+            int error = errno;
+            close(memory);
+            throw std::system_error(error, std::system_category(), "ProcessWrapper: shared memory");
+        }
+        return memory;
+    }
+
+private:
+    template <class Factory>
+    static void runChild(ProcessChannel *channel, const void *factory, pid_t zygote){
+        // called inside the child, forked by the zygote
+        T *object = 0;
+        try{
+            object = (*static_cast<const Factory*>(factory))();
+        }
+        catch(...){
+            object = 0;
+        }
+        if(!object){
+            channel->state.store(ProcessChannel::Failed, std::memory_order_release);
+            futexWakeShared(&channel->state);
+            _exit(1);
+        }
+        channel->state.store(ProcessChannel::Ready, std::memory_order_release);
+        futexWakeShared(&channel->state);
+        serve(object, channel, zygote);
+        delete object;
+        channel->stopped.store(1, std::memory_order_release);
+        _exit(0);               // the atexit handlers and the static objects belong to the parent
+    }
+    static void serve(T *object, ProcessChannel *channel, pid_t zygote){
+        // the event loop of the child, like the one of StdEventLoop; it ends also when the zygote has ended (the child has been
+        // adopted by another process), which is checked every time the child wakes up, or every 200 milliseconds while it sleeps
+        while(!channel->stopRequested.load(std::memory_order_relaxed)){
+            ProcessChannel::Slot *slot = channel->front();
+            if(slot){
+                if(slot->kind == ProcessChannel::SyncCall){
+                    slot->invoker(slot->payload, object, channel->reply.result);
+                    if(channel->reply.state.exchange(ProcessChannel::Done, std::memory_order_acq_rel) == ProcessChannel::Parked){
+                        futexWakeShared(&channel->reply.state, 1);
+                    }
+                }
+                else{
+                    slot->invoker(slot->payload, object, 0);
+                }
+                channel->pop();
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(channel->waitingProducers.load(std::memory_order_relaxed) > 0){
+                    channel->spaceEpoch.fetch_add(1);
+                    futexWakeShared(&channel->spaceEpoch);
+                }
+                continue;
+            }
+            if(!channel->isEmpty()){
+                std::this_thread::yield();          // a producer is completing its push()
+                continue;
+            }
+            channel->sleeping.store(1);
+            if(!channel->isEmpty() || channel->stopRequested.load()){
+                channel->sleeping.store(0);
+                continue;
+            }
+            futexWaitShared(&channel->sleeping, 1, 200);
+            channel->sleeping.store(0);
+            if(getppid() != zygote){
+                break;
+            }
+        }
+    }
+
+private:
+    template <class Functor>
+    static void checkCallable(){
+        static_assert(std::is_trivially_copyable<Functor>::value, "a process call is copied byte by byte, so it must be trivially copyable");
+        static_assert(sizeof(Functor) <= ProcessChannel::payloadSize, "a process call is too large for a slot of the ring");
+        static_assert(alignof(Functor) <= 16, "a process call has a too strict alignment");
+    }
+    template <class Functor>
+    static void invoke(void *functor, void *object, void *){
+        (*static_cast<Functor*>(functor))(static_cast<T*>(object));
+    }
+    template <class Functor, class Result>
+    static void invokeWithResult(void *functor, void *object, void *result){
+        Result value = (*static_cast<Functor*>(functor))(static_cast<T*>(object));
+        std::memcpy(result, &value, sizeof(Result));
+    }
+
+private:
+    ProcessWrapper0(const ProcessWrapper0 &);
+    ProcessWrapper0 &operator=(const ProcessWrapper0 &);
+
+};
+
+
+template <class T, class Arg1>
+class ProcessWrapper1: public ProcessWrapper0<T>
+{
+
+public:
+    ProcessWrapper1(Arg1 _arg1) :
+      ProcessWrapper0<T>(false){
+        initialize(_arg1, true);
+    }
+
+protected:
+    ProcessWrapper1(Arg1 _arg1, bool _enabled) :
+      ProcessWrapper0<T>(false){
+        initialize(_arg1, _enabled);
+    }
+
+private:
+    void initialize(Arg1 _arg1, bool _enabled){
+        arg1 = _arg1;
+        enabled1 = _enabled;              // if the argument number is greater than 1, it is obviously false
+        if(enabled1){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled1;
+    Arg1 arg1;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        this->startProcess([_arg1](){ return new T(_arg1); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2>
+class ProcessWrapper2: public ProcessWrapper1<T,Arg1>
+{
+
+public:
+    ProcessWrapper2(Arg1 _arg1, Arg2 _arg2) :
+      ProcessWrapper1<T,Arg1>(_arg1,false){
+        initialize(_arg2, true);
+    }
+
+protected:
+    ProcessWrapper2(Arg1 _arg1, Arg2 _arg2, bool _enabled) :
+      ProcessWrapper1<T,Arg1>(_arg1,false){
+        initialize(_arg2, _enabled);
+    }
+
+private:
+    void initialize(Arg2 _arg2, bool _enabled){
+        arg2 = _arg2;
+        enabled2 = _enabled;              // if the argument number is greater than 2, it is obviously false
+        if(enabled2){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled2;
+    Arg2 arg2;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        this->startProcess([_arg1, _arg2](){ return new T(_arg1,_arg2); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3>
+class ProcessWrapper3: public ProcessWrapper2<T,Arg1,Arg2>
+{
+
+public:
+    ProcessWrapper3(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3) :
+      ProcessWrapper2<T,Arg1,Arg2>(_arg1,_arg2,false){
+        initialize(_arg3, true);
+    }
+
+protected:
+    ProcessWrapper3(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, bool _enabled) :
+      ProcessWrapper2<T,Arg1,Arg2>(_arg1,_arg2,false){
+        initialize(_arg3, _enabled);
+    }
+
+private:
+    void initialize(Arg3 _arg3, bool _enabled){
+        arg3 = _arg3;
+        enabled3 = _enabled;              // if the argument number is greater than 3, it is obviously false
+        if(enabled3){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled3;
+    Arg3 arg3;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        Arg3 _arg3 = this->arg3;
+        this->startProcess([_arg1, _arg2, _arg3](){ return new T(_arg1,_arg2,_arg3); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4>
+class ProcessWrapper4: public ProcessWrapper3<T,Arg1,Arg2,Arg3>
+{
+
+public:
+    ProcessWrapper4(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4) :
+      ProcessWrapper3<T,Arg1,Arg2,Arg3>(_arg1,_arg2,_arg3,false){
+        initialize(_arg4, true);
+    }
+
+protected:
+    ProcessWrapper4(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, bool _enabled) :
+      ProcessWrapper3<T,Arg1,Arg2,Arg3>(_arg1,_arg2,_arg3,false){
+        initialize(_arg4, _enabled);
+    }
+
+private:
+    void initialize(Arg4 _arg4, bool _enabled){
+        arg4 = _arg4;
+        enabled4 = _enabled;              // if the argument number is greater than 4, it is obviously false
+        if(enabled4){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled4;
+    Arg4 arg4;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        Arg3 _arg3 = this->arg3;
+        Arg4 _arg4 = this->arg4;
+        this->startProcess([_arg1, _arg2, _arg3, _arg4](){ return new T(_arg1,_arg2,_arg3,_arg4); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5>
+class ProcessWrapper5: public ProcessWrapper4<T,Arg1,Arg2,Arg3,Arg4>
+{
+
+public:
+    ProcessWrapper5(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5) :
+      ProcessWrapper4<T,Arg1,Arg2,Arg3,Arg4>(_arg1,_arg2,_arg3,_arg4,false){
+        initialize(_arg5, true);
+    }
+
+protected:
+    ProcessWrapper5(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, bool _enabled) :
+      ProcessWrapper4<T,Arg1,Arg2,Arg3,Arg4>(_arg1,_arg2,_arg3,_arg4,false){
+        initialize(_arg5, _enabled);
+    }
+
+private:
+    void initialize(Arg5 _arg5, bool _enabled){
+        arg5 = _arg5;
+        enabled5 = _enabled;              // if the argument number is greater than 5, it is obviously false
+        if(enabled5){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled5;
+    Arg5 arg5;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        Arg3 _arg3 = this->arg3;
+        Arg4 _arg4 = this->arg4;
+        Arg5 _arg5 = this->arg5;
+        this->startProcess([_arg1, _arg2, _arg3, _arg4, _arg5](){ return new T(_arg1,_arg2,_arg3,_arg4,_arg5); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6>
+class ProcessWrapper6: public ProcessWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>
+{
+
+public:
+    ProcessWrapper6(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6) :
+      ProcessWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(_arg1,_arg2,_arg3,_arg4,_arg5,false){
+        initialize(_arg6, true);
+    }
+
+protected:
+    ProcessWrapper6(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, bool _enabled) :
+      ProcessWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(_arg1,_arg2,_arg3,_arg4,_arg5,false){
+        initialize(_arg6, _enabled);
+    }
+
+private:
+    void initialize(Arg6 _arg6, bool _enabled){
+        arg6 = _arg6;
+        enabled6 = _enabled;              // if the argument number is greater than 6, it is obviously false
+        if(enabled6){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled6;
+    Arg6 arg6;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        Arg3 _arg3 = this->arg3;
+        Arg4 _arg4 = this->arg4;
+        Arg5 _arg5 = this->arg5;
+        Arg6 _arg6 = this->arg6;
+        this->startProcess([_arg1, _arg2, _arg3, _arg4, _arg5, _arg6](){ return new T(_arg1,_arg2,_arg3,_arg4,_arg5,_arg6); });
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6, class Arg7>
+class ProcessWrapper7: public ProcessWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>
+{
+
+public:
+    ProcessWrapper7(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, Arg7 _arg7) :
+      ProcessWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(_arg1,_arg2,_arg3,_arg4,_arg5,_arg6,false){
+        initialize(_arg7, true);
+    }
+
+protected:
+    ProcessWrapper7(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, Arg7 _arg7, bool _enabled) :
+      ProcessWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(_arg1,_arg2,_arg3,_arg4,_arg5,_arg6,false){
+        initialize(_arg7, _enabled);
+    }
+
+private:
+    void initialize(Arg7 _arg7, bool _enabled){
+        arg7 = _arg7;
+        enabled7 = _enabled;              // if the argument number is greater than 7, it is obviously false
+        if(enabled7){
+            createProcess();
+        }
+    }
+
+protected:
+    bool enabled7;
+    Arg7 arg7;
+
+protected:
+    void createProcess(){
+        // the lambda is called inside the child, forked by the zygote, so it captures the arguments by value
+        Arg1 _arg1 = this->arg1;
+        Arg2 _arg2 = this->arg2;
+        Arg3 _arg3 = this->arg3;
+        Arg4 _arg4 = this->arg4;
+        Arg5 _arg5 = this->arg5;
+        Arg6 _arg6 = this->arg6;
+        Arg7 _arg7 = this->arg7;
+        this->startProcess([_arg1, _arg2, _arg3, _arg4, _arg5, _arg6, _arg7](){ return new T(_arg1,_arg2,_arg3,_arg4,_arg5,_arg6,_arg7); });
+    }
+
+};
+
+
+#endif // PROCESSWRAPPER_H
@@ -0,0 +1,306 @@
+/*
+
+    The RecyclingPool class is a per-thread allocator for the small objects used by the wrappers (the call envelopes and the
+    lifecycle objects like ThreadObjectTArgX, SemaphoreObject and its QSemaphores), which are often freed by a different
+    thread from the one that allocated them.
+
+    Every thread has a pool for each size class (32 to 1024 bytes, header included), and every block remembers its pool:
+        - a block freed by the owner thread goes back to the local free list, without any synchronization;
+        - a block freed by another thread is kept in a small per-thread batch, which is given back to the owner pool with a
+          single compare-and-swap when it is full, when the blocks of another pool arrive, or with RecyclingPool::flush()
+          (called by the event loops when they become idle);
+        - the owner takes all the returned blocks with a single exchange when its local free list is empty.
+    When a thread ends, its pools free their blocks, and the blocks still in use are freed directly when they are released (the
+    pools forget their owner, as a new thread can get the same thread-local storage).
+
+    The classes derived from RecyclingAllocated use the pools for new and delete (an object constructed inside a short-lived
+    thread can use a block allocated in advance by a long-lived one, with the placement new, so the block is recycled by the
+    long-lived thread); the statistics count the allocations and the frees which reach the system allocator, so in steady
+    state they should not grow:
+        RecyclingPool::Statistics before = RecyclingPool::statistics();
+        ....... do stuff .....
+        quint64 allocations = RecyclingPool::statistics().systemAllocations - before.systemAllocations;
+
+*/
+
+
+#ifndef RECYCLINGPOOL_H
+#define RECYCLINGPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+
+class RecyclingPool;
+
+struct RecyclingBlock
+{
+    RecyclingPool *pool;            // 0 for the blocks allocated directly by the system allocator
+    RecyclingBlock *next;
+};
+
+
+class RecyclingPool
+{
+
+public:
+    struct Statistics {
+        uint64_t systemAllocations;
+        uint64_t systemFrees;
+        uint64_t remoteBatches;
+    };
+
+public:
+    static void *allocate(size_t size){
+        int sizeClass = sizeClassFor(size + sizeof(RecyclingBlock));
+        ThreadPools *threadPools = currentThreadPools();
+        if(sizeClass < 0 || !threadPools){
+            return systemAllocate(size + sizeof(RecyclingBlock), 0) + 1;
+        }
+        RecyclingPool *pool = threadPools->pool(sizeClass);
+        RecyclingBlock *block = pool->freeList;
+        if(!block && pool->remoteFreeList.load(std::memory_order_relaxed)){
+            block = pool->remoteFreeList.exchange(0, std::memory_order_acquire);          // all the blocks given back by the other threads
+        }
+        if(block){
+            pool->freeList = block->next;
+        }
+        else{
+            block = systemAllocate(blockSize(sizeClass), pool);
+            pool->references.fetch_add(1, std::memory_order_relaxed);
+        }
+        block->pool = pool;
+        return block + 1;
+    }
+    static void deallocate(void *pointer){
+        if(!pointer){
+            return;
+        }
+        RecyclingBlock *block = static_cast<RecyclingBlock*>(pointer) - 1;
+        RecyclingPool *pool = block->pool;
+        if(!pool){
+            systemFree(block);
+            return;
+        }
+        ThreadPools *threadPools = currentThreadPools();
+        if(threadPools && pool->owner.load(std::memory_order_relaxed) == threadPools){
+            block->next = pool->freeList;
+            pool->freeList = block;
+            return;
+        }
+        if(!threadPools){
+            block->next = 0;
+            pool->giveBack(block, block);           // the thread is ending, so we cannot keep a batch anymore
+            return;
+        }
+        ThreadPools::Batch &batch = threadPools->batch;
+        if(batch.pool != pool){
+            batch.flush();
+            batch.pool = pool;
+        }
+        block->next = batch.head;
+        batch.head = block;
+        if(!batch.tail){
+            batch.tail = block;
+        }
+        if(++batch.count >= batchSize){
+            batch.flush();
+        }
+    }
+    static void flush(){
+        // gives back to their owners the blocks kept in the batch of the current thread
+        ThreadPools *threadPools = currentThreadPools();
+        if(threadPools){
+            threadPools->batch.flush();
+        }
+    }
+    static Statistics statistics(){
+        Statistics result;
+        result.systemAllocations = counter(SystemAllocations).load();
+        result.systemFrees = counter(SystemFrees).load();
+        result.remoteBatches = counter(RemoteBatches).load();
+        return result;
+    }
+
+private:
+    enum {sizeClasses = 6, batchSize = 32};
+    enum Counter {SystemAllocations, SystemFrees, RemoteBatches};         // global counters, so only the rare events are counted
+
+    struct ThreadPools {
+        struct Batch {
+            RecyclingPool *pool;
+            RecyclingBlock *head;
+            RecyclingBlock *tail;
+            int count;
+            void flush(){
+                if(pool && head){
+                    pool->giveBack(head, tail);
+                    counter(RemoteBatches)++;
+                }
+                pool = 0;
+                head = 0;
+                tail = 0;
+                count = 0;
+            }
+        };
+        RecyclingPool *pools[sizeClasses];
+        Batch batch;
+        ThreadPools(){
+            for(int i = 0; i < sizeClasses; i++){
+                pools[i] = 0;
+            }
+            batch.pool = 0;
+            batch.head = 0;
+            batch.tail = 0;
+            batch.count = 0;
+        }
+        ~ThreadPools(){
+            batch.flush();
+            threadEnded() = true;
+            for(int i = 0; i < sizeClasses; i++){
+                if(pools[i]){
+                    pools[i]->orphan();
+                }
+            }
+        }
+        RecyclingPool *pool(int sizeClass){
+            if(!pools[sizeClass]){
+                pools[sizeClass] = new RecyclingPool(this);
+            }
+            return pools[sizeClass];
+        }
+    };
+
+private:
+    explicit RecyclingPool(ThreadPools *_owner){
+        owner.store(_owner);
+        freeList = 0;
+        remoteFreeList.store(0);
+        references.store(1);            // the reference of the owner thread
+    }
+
+private:
+    std::atomic<ThreadPools*> owner;                // 0 when the owner thread has ended
+    RecyclingBlock *freeList;                       // used only by the owner thread
+    std::atomic<RecyclingBlock*> remoteFreeList;    // the blocks given back by the other threads, orphanedMark() when the owner has ended
+    std::atomic<long> references;                   // the blocks allocated from the system and not freed yet, plus the owner
+
+private:
+    void giveBack(RecyclingBlock *head, RecyclingBlock *tail){
+        RecyclingBlock *first = remoteFreeList.load(std::memory_order_relaxed);
+        do{
+            if(first == orphanedMark()){
+                tail->next = 0;
+                freeChain(head);        // the owner thread has ended, so nobody can reuse these blocks
+                return;
+            }
+            tail->next = first;
+        } while(!remoteFreeList.compare_exchange_weak(first, head, std::memory_order_release, std::memory_order_relaxed));
+    }
+    void orphan(){
+        owner.store(0, std::memory_order_relaxed);      // the next thread with the same thread-local storage must not take the blocks
+        freeChain(freeList, false);
+        freeList = 0;
+        freeChain(remoteFreeList.exchange(orphanedMark(), std::memory_order_acquire), false);
+        release(1);
+    }
+    void freeChain(RecyclingBlock *block, bool canDeletePool = true){
+        long freed = 0;
+        while(block){
+            RecyclingBlock *next = block->next;
+            systemFree(block);
+            block = next;
+            freed++;
+        }
+        if(freed && canDeletePool){
+            release(freed);
+        }
+        else if(freed){
+            references.fetch_sub(freed, std::memory_order_acq_rel);
+        }
+    }
+    void release(long count){
+        if(references.fetch_sub(count, std::memory_order_acq_rel) == count){
+            delete this;            // the owner has ended and all its blocks have been freed
+        }
+    }
+
+private:
+    static RecyclingBlock *orphanedMark(){
+        static RecyclingBlock mark;
+        return &mark;
+    }
+    static int sizeClassFor(size_t size){
+        int sizeClass = 0;
+        while(sizeClass < sizeClasses && blockSize(sizeClass) < size){
+            sizeClass++;
+        }
+        return sizeClass < sizeClasses ? sizeClass : -1;
+    }
+    static size_t blockSize(int sizeClass){return (size_t)32 << sizeClass;}
+    static RecyclingBlock *systemAllocate(size_t size, RecyclingPool *pool){
+        RecyclingBlock *block = static_cast<RecyclingBlock*>(std::malloc(size));
+        if(!block){
+            throw std::bad_alloc();
+        }
+        block->pool = pool;
+        counter(SystemAllocations)++;
+        return block;
+    }
+    static void systemFree(RecyclingBlock *block){
+        std::free(block);
+        counter(SystemFrees)++;
+    }
+    static std::atomic<uint64_t> &counter(Counter which){
+        static std::atomic<uint64_t> counters[3];
+        return counters[which];
+    }
+    static bool &threadEnded(){
+        static thread_local bool ended = false;         // a trivial type, so it is still valid during the thread_local destructors
+        return ended;
+    }
+    static ThreadPools *currentThreadPools(){
+        if(threadEnded()){
+            return 0;
+        }
+        static thread_local ThreadPools threadPools;
+        return &threadPools;
+    }
+
+private:
+    RecyclingPool(const RecyclingPool &);
+    RecyclingPool &operator=(const RecyclingPool &);
+
+};
+
+
+class RecyclingAllocated
+{
+
+public:
+    static void *operator new(size_t size){return RecyclingPool::allocate(size);}
+    static void *operator new(size_t, void *block){return block;}            // a block from RecyclingPool::allocate()
+    static void operator delete(void *pointer){RecyclingPool::deallocate(pointer);}
+    static void operator delete(void *, void *){}                             // the block stays with the one who allocated it
+
+};
+
+
+template <class X>
+X *recyclingNew(){
+    return new (RecyclingPool::allocate(sizeof(X))) X();
+}
+
+template <class X>
+void recyclingDelete(X *object){
+    if(object){
+        object->~X();
+        RecyclingPool::deallocate(object);
+    }
+}
+
+
+#endif // RECYCLINGPOOL_H
@@ -5,8 +5,8 @@ SemaphoreObject::SemaphoreObject(QObject *parent) :
 {
 
     mainConstructor = true;
-    semaphoreCreation = new QSemaphore();
-    semaphoreDeletion = new QSemaphore();
+    semaphoreCreation = recyclingNew<QSemaphore>();
+    semaphoreDeletion = recyclingNew<QSemaphore>();
 
 }
 
@@ -14,8 +14,9 @@
 #include <QSemaphore>
 #include <QThread>
 #include <QDebug>
+#include "recyclingpool.h"
 
-class SemaphoreObject : public QObject
+class SemaphoreObject : public QObject, public RecyclingAllocated
 {
     Q_OBJECT
 public:
@@ -23,8 +24,8 @@ public:
     explicit SemaphoreObject(QSemaphore *_semaphoreCreation, QSemaphore *_semaphoreDeletion, QObject *parent = 0);
     ~SemaphoreObject(){
         if(mainConstructor){
-            delete semaphoreCreation;
-            delete semaphoreDeletion;
+            recyclingDelete(semaphoreCreation);
+            recyclingDelete(semaphoreDeletion);
         }
     }
 
@@ -0,0 +1,124 @@
+/*
+
+    The StdEventLoop class is the Qt-free event loop used by StdThread (THREADWRAPPER_STD_BACKEND): the posted calls (CallEnvelope
+    objects) are pushed in the lock-free CallLanes from any thread, and executed (in order within each lane, the urgent lane
+    first) by the thread running exec(). When there is nothing to do, the thread sleeps on a futex, and a producer pays the wake
+    system call only if the loop is actually sleeping.
+
+    The loop also drives the TimerWheel of its thread (if TimerWheel::forCurrentThread() has been called inside the thread),
+    using the next timeout of the wheel as the timeout of the futex, and it samples the cpu domain of the thread for its TrafficNode
+    (trafficnode.h) when it wakes up.
+
+*/
+
+
+#ifndef STDEVENTLOOP_H
+#define STDEVENTLOOP_H
+
+#include <atomic>
+#include <thread>
+#include "callenvelope.h"
+#include "futex.h"
+#include "timerwheel.h"
+#include "trafficnode.h"
+
+
+class StdEventLoop
+{
+
+public:
+    StdEventLoop(){
+        sleeping.store(0);
+        quitRequested.store(false);
+    }
+    ~StdEventLoop(){
+        // the calls never executed (posted after quit()) are discarded
+        CallEnvelope *envelope;
+        while((envelope = lanes.next()) != 0 || !lanes.isEmpty()){
+            if(envelope){
+                envelope->discard();
+            }
+        }
+    }
+
+public:
+    TrafficNode trafficNode;            // attached to the thread by StdThread
+
+private:
+    CallLanes lanes;
+    std::atomic<int> sleeping;          // 1 while the loop thread is (or is going to be) blocked on the futex
+    std::atomic<bool> quitRequested;
+
+public:
+    void postEnvelope(CallEnvelope *envelope, CallLane lane = BulkLane){
+        trafficNode.recordPost();
+        lanes.push(envelope, lane);
+        wake();
+    }
+    template <class Functor>
+    void post(Functor functor, CallLane lane = BulkLane){
+        postEnvelope(new FunctorCallEnvelope<Functor>(functor), lane);
+    }
+    void quit(){
+        quitRequested.store(true);
+        wake();
+    }
+    int exec(){
+        unsigned int executed = 0;
+        trafficNode.sampleDomain();
+        while(!quitRequested.load(std::memory_order_relaxed)){
+            CallEnvelope *envelope = lanes.next();
+            if(envelope){
+                envelope->run();
+                envelope->release();
+                if((++executed & 63) == 0){
+                    advanceTimers();            // the timers are not starved by a long burst of calls
+                    trafficNode.sampleDomain();
+                }
+                continue;
+            }
+            if(!lanes.isEmpty()){
+                std::this_thread::yield();      // a producer is completing its push()
+                continue;
+            }
+            if(advanceTimers()){
+                continue;
+            }
+            RecyclingPool::flush();             // before sleeping, we give back the envelopes of the other threads
+            sleeping.store(1);
+            if(!lanes.isEmpty() || quitRequested.load()){
+                sleeping.store(0);
+                continue;
+            }
+            TimerWheel *wheel = stdThreadTimerWheel().get();
+            futexWait(&sleeping, 1, wheel ? wheel->nextTimeout() : -1);
+            sleeping.store(0);
+            trafficNode.sampleDomain();
+        }
+        quitRequested.store(false);
+        return 0;
+    }
+
+private:
+    void wake(){
+        if(sleeping.exchange(0) == 1){
+            futexWake(&sleeping, 1);
+        }
+    }
+    bool advanceTimers(){
+        TimerWheel *wheel = stdThreadTimerWheel().get();
+        if(wheel && wheel->count() > 0 && wheel->nextTimeout() == 0){
+            wheel->advance();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    StdEventLoop(const StdEventLoop &);
+    StdEventLoop &operator=(const StdEventLoop &);
+
+};
+
+
+#endif // STDEVENTLOOP_H
@@ -0,0 +1,76 @@
+/*
+
+    This class is the Qt-free version of SemaphoreObject, used by the StdThreadObjectTArgX classes (THREADWRAPPER_STD_BACKEND) to
+    create and delete the object of the class T inside the StdThread; the semaphores are StdSemaphore objects, based on futexes.
+    As no slot is needed here, the same object is shared by the wrapper and by the thread.
+    To better understand the meaning, refer to the code of the "ThreadWrapper" and "StdThreadObject" classes.
+
+*/
+
+
+#ifndef STDSEMAPHOREOBJECT_H
+#define STDSEMAPHOREOBJECT_H
+
+#include <atomic>
+#include "futex.h"
+
+
+class StdSemaphore
+{
+
+public:
+    explicit StdSemaphore(int n = 0){
+        available.store(n);
+    }
+
+private:
+    std::atomic<int> available;
+
+public:
+    void acquire(int n = 1){
+        int current = available.load();
+        while(true){
+            if(current >= n){
+                if(available.compare_exchange_weak(current, current - n)){
+                    return;
+                }
+            }
+            else{
+                futexWait(&available, current);
+                current = available.load();
+            }
+        }
+    }
+    void release(int n = 1){
+        available.fetch_add(n);
+        futexWake(&available);
+    }
+
+private:
+    StdSemaphore(const StdSemaphore &);
+    StdSemaphore &operator=(const StdSemaphore &);
+
+};
+
+
+class StdSemaphoreObject
+{
+
+public:
+    StdSemaphoreObject(){
+    }
+
+public:
+    StdSemaphore semaphoreCreation;
+    StdSemaphore semaphoreDeletion;
+
+public:
+    void acquireResourceForSemaphoreCreation(){semaphoreCreation.acquire(1);}
+    void acquireResourceForSemaphoreDeletion(){semaphoreDeletion.acquire(1);}
+    void releaseResourceForSemaphoreCreation(){semaphoreCreation.release(1);}
+    void releaseResourceForSemaphoreDeletion(){semaphoreDeletion.release(1);}
+
+};
+
+
+#endif // STDSEMAPHOREOBJECT_H
@@ -0,0 +1,121 @@
+/*
+
+    The StdThread class is the Qt-free replacement of QThread used with THREADWRAPPER_STD_BACKEND: it is a std::thread running
+    the virtual run() method, whose default implementation simply runs the StdEventLoop of the thread with exec().
+    The priorities have the same names of the QThread ones; on Linux they are applied as nice values of the thread (so, without
+    privileges, only the priorities lower than the inherited one are effective), on the other systems they are ignored.
+
+*/
+
+
+#ifndef STDTHREAD_H
+#define STDTHREAD_H
+
+#include <thread>
+#include "stdeventloop.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+class StdThread : public RecyclingAllocated
+{
+
+public:
+    enum Priority {
+        IdlePriority,
+        LowestPriority,
+        LowPriority,
+        NormalPriority,
+        HighPriority,
+        HighestPriority,
+        TimeCriticalPriority,
+        InheritPriority
+    };
+
+public:
+    StdThread(){
+    }
+    virtual ~StdThread(){
+        wait();
+    }
+
+private:
+    std::thread thread;
+    StdEventLoop eventLoop;
+    Priority priority;
+
+public:
+    void start(Priority _priority = InheritPriority){
+        priority = _priority;
+        thread = std::thread(&StdThread::threadMain, this);
+    }
+    void quit(){
+        eventLoop.quit();
+    }
+    void wait(){
+        if(thread.joinable()){
+            thread.join();
+        }
+    }
+    template <class Functor>
+    void post(Functor functor, CallLane lane = BulkLane){
+        eventLoop.post(functor, lane);
+    }
+    void postEnvelope(CallEnvelope *envelope, CallLane lane = BulkLane){
+        eventLoop.postEnvelope(envelope, lane);
+    }
+    bool isCurrentThread() const {return currentThread() == this;}
+
+public:
+    static StdThread *currentThread(){return currentThreadSlot();}
+
+protected:
+    virtual void run(){
+        exec();
+    }
+    int exec(){
+        return eventLoop.exec();
+    }
+
+private:
+    static StdThread *&currentThreadSlot(){
+        static thread_local StdThread *current = 0;
+        return current;
+    }
+    void threadMain(){
+        currentThreadSlot() = this;
+        applyPriority();
+        eventLoop.trafficNode.attachCurrentThread();         // before the object T is created, so its affinity is the original one
+        run();
+        eventLoop.trafficNode.detachCurrentThread();
+        currentThreadSlot() = 0;
+    }
+    void applyPriority(){
+#if defined(__linux__)
+        static const int niceValues[] = {19, 15, 5, 0, -5, -10, -15};
+        if(priority == InheritPriority){
+            return;
+        }
+        if(priority == IdlePriority){
+            struct sched_param parameters;
+            parameters.sched_priority = 0;
+            sched_setscheduler(0, SCHED_IDLE, &parameters);
+            return;
+        }
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), niceValues[priority]);
+#endif
+    }
+
+private:
+    StdThread(const StdThread &);
+    StdThread &operator=(const StdThread &);
+
+};
+
+
+#endif // STDTHREAD_H
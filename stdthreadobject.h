@@ -0,0 +1,266 @@
+/*
+
+    The StdThreadObjectTArgX classes are the Qt-free version of the ThreadObjectTArgX classes (THREADWRAPPER_STD_BACKEND): they include
+    an object of the class T in a StdThread.
+
+    Depending on the arguments used for the object, we can distinguish between 8 classes:
+        StdThreadObjectTArg0, that does not use any argument
+        StdThreadObjectTArg1, that use 1 argument
+        StdThreadObjectTArg2, that use 2 argument
+        StdThreadObjectTArg3, that use 3 argument
+        StdThreadObjectTArg4, that use 4 argument
+        StdThreadObjectTArg5, that use 5 argument
+        StdThreadObjectTArg6, that use 6 argument
+        StdThreadObjectTArg7, that use 7 argument
+    These classes are used by the ThreadWrapperX classes of stdthreadwrapper.h to generate the wrappers responsible for creating
+    of a StdThread associated with an object of the class T.
+
+*/
+
+
+#ifndef STDTHREADOBJECT_H
+#define STDTHREADOBJECT_H
+
+#include "stdsemaphoreobject.h"
+#include "stdthread.h"
+
+
+template <class T>
+class StdThreadObjectTArg0: public StdThread
+{
+
+public:
+    StdThreadObjectTArg0(T **_t, StdSemaphoreObject *_semaphoreObject){
+        t = _t;
+        semaphoreObject = _semaphoreObject;
+    }
+
+public:
+    T **t;
+
+protected:
+    StdSemaphoreObject *semaphoreObject;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();         // the object t is ready, so the wrapper constructor can return
+        StdThread::exec();
+    }
+
+public:
+    void deleteObjectT(){
+        // called inside the thread by the wrapper destructor, it replaces the "destroyed" connection of the Qt version
+        delete *t;
+        *t = 0;
+        StdThread::quit();          // the calls posted after the deletion must not be executed
+        semaphoreObject->releaseResourceForSemaphoreDeletion();
+    }
+
+protected:
+    void createObjectT(){
+        *t = new T();
+    }
+
+};
+
+
+template <class T, class Arg1>
+class StdThreadObjectTArg1: public StdThreadObjectTArg0<T>
+{
+
+public:
+    StdThreadObjectTArg1(T **_t, Arg1 _arg1, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg0<T>(_t,_semaphoreObject){
+        arg1 = _arg1;
+    }
+
+protected:
+    Arg1 arg1;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(arg1);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2>
+class StdThreadObjectTArg2: public StdThreadObjectTArg1<T,Arg1>
+{
+
+public:
+    StdThreadObjectTArg2(T **_t, Arg1 _arg1, Arg2 _arg2, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg1<T,Arg1>(_t,_arg1,_semaphoreObject){
+        arg2 = _arg2;
+    }
+
+protected:
+    Arg2 arg2;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,arg2);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3>
+class StdThreadObjectTArg3: public StdThreadObjectTArg2<T,Arg1,Arg2>
+{
+
+public:
+    StdThreadObjectTArg3(T **_t, Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg2<T,Arg1,Arg2>(_t,_arg1,_arg2,_semaphoreObject){
+        arg3 = _arg3;
+    }
+
+protected:
+    Arg3 arg3;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,this->arg2,arg3);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4>
+class StdThreadObjectTArg4: public StdThreadObjectTArg3<T,Arg1,Arg2,Arg3>
+{
+
+public:
+    StdThreadObjectTArg4(T **_t, Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg3<T,Arg1,Arg2,Arg3>(_t,_arg1,_arg2,_arg3,_semaphoreObject){
+        arg4 = _arg4;
+    }
+
+protected:
+    Arg4 arg4;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,this->arg2,this->arg3,arg4);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5>
+class StdThreadObjectTArg5: public StdThreadObjectTArg4<T,Arg1,Arg2,Arg3,Arg4>
+{
+
+public:
+    StdThreadObjectTArg5(T **_t, Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg4<T,Arg1,Arg2,Arg3,Arg4>(_t,_arg1,_arg2,_arg3,_arg4,_semaphoreObject){
+        arg5 = _arg5;
+    }
+
+protected:
+    Arg5 arg5;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,this->arg2,this->arg3,this->arg4,arg5);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6>
+class StdThreadObjectTArg6: public StdThreadObjectTArg5<T,Arg1,Arg2,Arg3,Arg4,Arg5>
+{
+
+public:
+    StdThreadObjectTArg6(T **_t, Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(_t,_arg1,_arg2,_arg3,_arg4,_arg5,_semaphoreObject){
+        arg6 = _arg6;
+    }
+
+protected:
+    Arg6 arg6;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,this->arg2,this->arg3,this->arg4,this->arg5,arg6);
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6, class Arg7>
+class StdThreadObjectTArg7: public StdThreadObjectTArg6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>
+{
+
+public:
+    StdThreadObjectTArg7(T **_t, Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, Arg7 _arg7, StdSemaphoreObject *_semaphoreObject) :
+      StdThreadObjectTArg6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(_t,_arg1,_arg2,_arg3,_arg4,_arg5,_arg6,_semaphoreObject){
+        arg7 = _arg7;
+    }
+
+protected:
+    Arg7 arg7;
+
+protected:
+    void run(){
+        createObjectT();
+        this->semaphoreObject->releaseResourceForSemaphoreCreation();
+        StdThread::exec();
+    }
+
+protected:
+    void createObjectT(){
+        *(this->t) = new T(this->arg1,this->arg2,this->arg3,this->arg4,this->arg5,this->arg6,arg7);
+    }
+
+};
+
+
+
+
+#endif // STDTHREADOBJECT_H
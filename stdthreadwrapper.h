@@ -0,0 +1,469 @@
+/*
+
+    These ThreadWrapperX classes are the Qt-free version of the ones in threadwrapper.h, selected at compile time defining
+    THREADWRAPPER_STD_BACKEND (threadwrapper.h includes this file instead of its own classes), for the headless programs
+    which do not need QtCore.
+    They have the same semantics: the object of the class T (which does not need to be QObject derived) is constructed
+    inside its thread, the constructor and the destructor of the wrapper return only after the creation and the deletion of the
+    object, and post() calls a callable on the object inside its thread. The thread is a StdThread (a std::thread with a lock-free
+    task queue and a futex wakeup), and the priorities are the StdThread ones, for example StdThread::HighestPriority.
+
+*/
+
+
+#ifndef STDTHREADWRAPPER_H
+#define STDTHREADWRAPPER_H
+
+#include <mutex>
+#include "stdthreadobject.h"
+#include "synccall.h"
+
+
+template <class T>
+class ThreadWrapper0
+{
+
+public:
+    ThreadWrapper0(StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+      syncCallEnvelope(&t_){
+        initialize(_threadPriority, true);
+    }
+
+protected:
+    ThreadWrapper0(StdThread::Priority _threadPriority, bool _enabled) :
+      syncCallEnvelope(&t_){
+        initialize(_threadPriority, _enabled);
+    }
+
+private:
+    void initialize(StdThread::Priority _threadPriority, bool _enabled){
+        threadPriority = _threadPriority;
+        enabled0 = _enabled;          // if there are arguments, it is obviously false
+        if(enabled0){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper0(){
+        if(enabled0){
+            deleteThreadObject();
+        }
+    }
+
+protected:
+    T *t_;
+
+protected:
+    StdSemaphoreObject semaphoreObject;
+    StdThreadObjectTArg0<T> *threadObjectTArg0;
+    StdThread *thread;
+    StdThread::Priority threadPriority;
+    bool enabled0;
+    SyncCallEnvelope<T> syncCallEnvelope;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg0 = new StdThreadObjectTArg0<T>(&t_,&semaphoreObject);
+        thread = dynamic_cast<StdThread*>(threadObjectTArg0);                // we use the thread variable to simplify the code
+        startThread();
+    }
+    void startThread(){
+        try{
+            thread->start(threadPriority);
+        }
+        catch(...){
+            delete thread;          // std::system_error if the thread cannot be created: the wrapper constructor throws it
+            thread = 0;
+            throw;
+        }
+        semaphoreObject.acquireResourceForSemaphoreCreation();          // we wait the resource release for semaphoreCreation from the semaphoreObject inside the thread
+    }
+    void deleteThreadObject(){
+        // now we post the deletion of the objectT to the thread, which releases the semaphoreDeletion resource just after it;
+        // the deletion goes in the urgent lane, so it does not wait for the pending bulk calls
+        StdThreadObjectTArg0<T> *threadObject = dynamic_cast<StdThreadObjectTArg0<T>*>(thread);
+        thread->post([threadObject](){ threadObject->deleteObjectT(); }, UrgentLane);
+        this->semaphoreObject.acquireResourceForSemaphoreDeletion();            // we wait the resource release for semaphoreDeletion from the thread
+        thread->quit();     // we inform the thread to stop hisself
+        thread->wait();     // then we wait the end of the event loop
+        delete thread;
+    }
+
+public:
+    T* t() const {return t_;}
+
+public:
+    template <class Functor>
+    void post(Functor functor, CallLane lane = BulkLane){
+        // the functor is called inside the thread of t_ (with t_ as argument), after the calls already posted to the same lane
+        T *objectT = t_;
+        thread->post([functor, objectT]() mutable { functor(objectT); }, lane);
+    }
+    template <class Functor>
+    bool invokeSync(Functor functor, CallLane lane = BulkLane){
+        // the functor is called inside the thread of t_ (with t_ as argument), and we wait for its completion; it returns false,
+        // without calling the functor, if the wait would be a deadlock or if the object has been deleted meanwhile; if the functor
+        // throws an exception, it is thrown again here
+        if(thread->isCurrentThread()){
+            functor(t_);            // we are already inside the thread of t_, so we call it directly
+            return true;
+        }
+        static thread_local char threadKey;         // the key of the threads which are not StdThread
+        const void *caller = StdThread::currentThread() ? (const void*)StdThread::currentThread() : (const void*)&threadKey;
+        if(!SyncCallGraph::enter(caller, thread)){
+            return false;
+        }
+        bool executed;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(syncCallEnvelope.slot.callerMutex);
+            syncCallEnvelope.slot.template prepare<T>(&functor);
+            thread->postEnvelope(&syncCallEnvelope, lane);         // the pre-allocated envelope, so the handoff does not allocate anything
+            executed = syncCallEnvelope.slot.wait();
+            error = syncCallEnvelope.slot.takeError();
+        }
+        SyncCallGraph::leave(caller);
+        if(error){
+            std::rethrow_exception(error);
+        }
+        return executed;
+    }
+
+};
+
+
+template <class T, class Arg1>
+class ThreadWrapper1: public ThreadWrapper0<T>
+{
+
+public:
+    ThreadWrapper1(Arg1 _arg1, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+      ThreadWrapper0<T>(_threadPriority, false){
+        initialize(_arg1, true);
+    }
+
+protected:
+    ThreadWrapper1(Arg1 _arg1, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper0<T>(_threadPriority, false){
+        initialize(_arg1, _enabled);
+    }
+
+private:
+    void initialize(Arg1 _arg1, bool _enabled){
+        arg1 = _arg1;
+        enabled1 = _enabled;              // if the argument number is greater than 1, it is obviously false
+        if(enabled1){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper1(){
+        if(enabled1){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled1;
+    Arg1 arg1;
+    StdThreadObjectTArg1<T,Arg1> *threadObjectTArg1;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg1 = new StdThreadObjectTArg1<T,Arg1>(&(this->t_),arg1,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg1);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2>
+class ThreadWrapper2: public ThreadWrapper1<T,Arg1>
+{
+
+public:
+    ThreadWrapper2(Arg1 _arg1, Arg2 _arg2, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper1<T,Arg1>(_arg1, _threadPriority, false){
+        initialize(_arg2, true);
+    }
+
+protected:
+    ThreadWrapper2(Arg1 _arg1, Arg2 _arg2, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper1<T,Arg1>(_arg1, _threadPriority, false){
+        initialize(_arg2, _enabled);
+    }
+
+private:
+    void initialize(Arg2 _arg2, bool _enabled){
+        arg2 = _arg2;
+        enabled2 = _enabled;              // if the argument number is greater than 2, it is obviously false
+        if(enabled2){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper2(){
+        if(enabled2){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled2;
+    Arg2 arg2;
+    StdThreadObjectTArg2<T,Arg1,Arg2> *threadObjectTArg2;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg2 = new StdThreadObjectTArg2<T,Arg1,Arg2>(&(this->t_),this->arg1,arg2,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg2);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3>
+class ThreadWrapper3: public ThreadWrapper2<T,Arg1,Arg2>
+{
+
+public:
+    ThreadWrapper3(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper2<T,Arg1,Arg2>(_arg1, _arg2, _threadPriority, false){
+        initialize(_arg3, true);
+    }
+
+protected:
+    ThreadWrapper3(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper2<T,Arg1,Arg2>(_arg1, _arg2, _threadPriority, false){
+        initialize(_arg3, _enabled);
+    }
+
+private:
+    void initialize(Arg3 _arg3, bool _enabled){
+        arg3 = _arg3;
+        enabled3 = _enabled;              // if the argument number is greater than 3, it is obviously false
+        if(enabled3){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper3(){
+        if(enabled3){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled3;
+    Arg3 arg3;
+    StdThreadObjectTArg3<T,Arg1,Arg2,Arg3> *threadObjectTArg3;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg3 = new StdThreadObjectTArg3<T,Arg1,Arg2,Arg3>(&(this->t_),this->arg1,this->arg2,arg3,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg3);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4>
+class ThreadWrapper4: public ThreadWrapper3<T,Arg1,Arg2,Arg3>
+{
+
+public:
+    ThreadWrapper4(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper3<T,Arg1,Arg2,Arg3>(_arg1, _arg2, _arg3, _threadPriority, false){
+        initialize(_arg4, true);
+    }
+
+protected:
+    ThreadWrapper4(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper3<T,Arg1,Arg2,Arg3>(_arg1, _arg2, _arg3, _threadPriority, false){
+        initialize(_arg4, _enabled);
+    }
+
+private:
+    void initialize(Arg4 _arg4, bool _enabled){
+        arg4 = _arg4;
+        enabled4 = _enabled;              // if the argument number is greater than 4, it is obviously false
+        if(enabled4){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper4(){
+        if(enabled4){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled4;
+    Arg4 arg4;
+    StdThreadObjectTArg4<T,Arg1,Arg2,Arg3,Arg4> *threadObjectTArg4;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg4 = new StdThreadObjectTArg4<T,Arg1,Arg2,Arg3,Arg4>(&(this->t_),this->arg1,this->arg2,this->arg3,arg4,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg4);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5>
+class ThreadWrapper5: public ThreadWrapper4<T,Arg1,Arg2,Arg3,Arg4>
+{
+
+public:
+    ThreadWrapper5(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper4<T,Arg1,Arg2,Arg3,Arg4>(_arg1, _arg2, _arg3, _arg4, _threadPriority, false){
+        initialize(_arg5, true);
+    }
+
+protected:
+    ThreadWrapper5(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper4<T,Arg1,Arg2,Arg3,Arg4>(_arg1, _arg2, _arg3, _arg4, _threadPriority, false){
+        initialize(_arg5, _enabled);
+    }
+
+private:
+    void initialize(Arg5 _arg5, bool _enabled){
+        arg5 = _arg5;
+        enabled5 = _enabled;              // if the argument number is greater than 5, it is obviously false
+        if(enabled5){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper5(){
+        if(enabled5){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled5;
+    Arg5 arg5;
+    StdThreadObjectTArg5<T,Arg1,Arg2,Arg3,Arg4,Arg5> *threadObjectTArg5;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg5 = new StdThreadObjectTArg5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(&(this->t_),this->arg1,this->arg2,this->arg3,this->arg4,arg5,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg5);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6>
+class ThreadWrapper6: public ThreadWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>
+{
+
+public:
+    ThreadWrapper6(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(_arg1, _arg2, _arg3, _arg4, _arg5, _threadPriority, false){
+        initialize(_arg6, true);
+    }
+
+protected:
+    ThreadWrapper6(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper5<T,Arg1,Arg2,Arg3,Arg4,Arg5>(_arg1, _arg2, _arg3, _arg4, _arg5, _threadPriority, false){
+        initialize(_arg6, _enabled);
+    }
+
+private:
+    void initialize(Arg6 _arg6, bool _enabled){
+        arg6 = _arg6;
+        enabled6 = _enabled;              // if the argument number is greater than 6, it is obviously false
+        if(enabled6){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper6(){
+        if(enabled6){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled6;
+    Arg6 arg6;
+    StdThreadObjectTArg6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6> *threadObjectTArg6;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg6 = new StdThreadObjectTArg6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(&(this->t_),this->arg1,this->arg2,this->arg3,this->arg4,this->arg5,arg6,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg6);
+        this->startThread();
+    }
+
+};
+
+
+template <class T, class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6, class Arg7>
+class ThreadWrapper7: public ThreadWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>
+{
+
+public:
+    ThreadWrapper7(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, Arg7 _arg7, StdThread::Priority _threadPriority = StdThread::InheritPriority) :
+        ThreadWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(_arg1, _arg2, _arg3, _arg4, _arg5, _arg6, _threadPriority, false){
+        initialize(_arg7, true);
+    }
+
+protected:
+    ThreadWrapper7(Arg1 _arg1, Arg2 _arg2, Arg3 _arg3, Arg4 _arg4, Arg5 _arg5, Arg6 _arg6, Arg7 _arg7, StdThread::Priority _threadPriority, bool _enabled) :
+      ThreadWrapper6<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6>(_arg1, _arg2, _arg3, _arg4, _arg5, _arg6, _threadPriority, false){
+        initialize(_arg7, _enabled);
+    }
+
+private:
+    void initialize(Arg7 _arg7, bool _enabled){
+        arg7 = _arg7;
+        enabled7 = _enabled;              // if the argument number is greater than 7, it is obviously false
+        if(enabled7){
+            createThreadObject();
+        }
+    }
+
+public:
+    ~ThreadWrapper7(){
+        if(enabled7){
+            this->deleteThreadObject();
+        }
+    }
+
+protected:
+    bool enabled7;
+    Arg7 arg7;
+    StdThreadObjectTArg7<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6,Arg7> *threadObjectTArg7;
+
+protected:
+    void createThreadObject(){
+        threadObjectTArg7 = new StdThreadObjectTArg7<T,Arg1,Arg2,Arg3,Arg4,Arg5,Arg6,Arg7>(&(this->t_),this->arg1,this->arg2,this->arg3,this->arg4,this->arg5,this->arg6,arg7,&(this->semaphoreObject));
+        this->thread = dynamic_cast<StdThread*>(threadObjectTArg7);
+        this->startThread();
+    }
+
+};
+
+
+
+
+
+
+#endif // STDTHREADWRAPPER_H
@@ -0,0 +1,147 @@
+/*
+
+    The processwrapperbench program measures the costs of the ProcessWrapperX classes (processwrapper.h) against the ThreadWrapperX
+    ones, for the same object:
+        create      the constructor of the wrapper (the request to the zygote, its fork and the creation of the object in the child,
+                    or the thread start)
+        delete      the destructor of the wrapper
+        sync call   a round trip of invokeSync() with an int result
+        post        the cost of a post() for the caller, with the child (or the thread) executing the calls meanwhile
+    It prints the median and the 99th percentile of create, delete and sync call, and the average of post.
+    The zygote of the ProcessWrapperX classes is started at the beginning, while the process has a single thread.
+
+    Usage:
+        processwrapperbench [--wrappers N] [--calls N] [--posts N]
+
+    Build (from this directory), with the Qt-free backend:
+        g++ -std=c++11 -O2 -DTHREADWRAPPER_STD_BACKEND -I.. processwrapperbench.cpp -pthread -o processwrapperbench
+
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "processwrapper.h"
+#include "threadwrapper.h"
+
+
+typedef std::chrono::steady_clock Clock;
+
+
+class BenchObject
+{
+
+public:
+    BenchObject(){
+        total = 0;
+    }
+    explicit BenchObject(int _total){
+        total = _total;
+    }
+
+public:
+    long total;
+
+};
+
+
+class Samples
+{
+
+public:
+    void start(){
+        begin = Clock::now();
+    }
+    void stop(){
+        values.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+    }
+    void print(const char *backend, const char *operation){
+        std::sort(values.begin(), values.end());
+        std::printf("%-8s %-10s p50 %8.2f us  p99 %8.2f us  (%d samples)\n", backend, operation, values[values.size() / 2],
+                    values[values.size() * 99 / 100], (int)values.size());
+        values.clear();
+    }
+
+private:
+    Clock::time_point begin;
+    std::vector<double> values;
+
+};
+
+
+static void invokeWithResult(ProcessWrapper1<BenchObject, int> &wrapper, int value, int *result){
+    wrapper.invokeSync([value](BenchObject *object){ return (int)object->total + value; }, result);
+}
+
+static void invokeWithResult(ThreadWrapper1<BenchObject, int> &wrapper, int value, int *result){
+    wrapper.invokeSync([value, result](BenchObject *object){ *result = (int)object->total + value; });
+}
+
+
+template <class Wrapper>
+static void measure(const char *backend, int wrappers, int calls, int posts){
+    Samples samples;
+    for(int i = 0; i < wrappers; i++){
+        samples.start();
+        Wrapper *wrapper = new Wrapper(i);
+        samples.stop();
+        delete wrapper;
+    }
+    samples.print(backend, "create");
+    for(int i = 0; i < wrappers; i++){
+        Wrapper *wrapper = new Wrapper(i);
+        samples.start();
+        delete wrapper;
+        samples.stop();
+    }
+    samples.print(backend, "delete");
+    Wrapper wrapper(0);
+    for(int i = 0; i < calls; i++){
+        int result = 0;
+        samples.start();
+        invokeWithResult(wrapper, i, &result);
+        samples.stop();
+    }
+    samples.print(backend, "sync call");
+    Clock::time_point begin = Clock::now();
+    for(int i = 0; i < posts; i++){
+        wrapper.post([](BenchObject *object){ object->total++; });
+    }
+    double postMicros = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    int result = 0;
+    invokeWithResult(wrapper, 0, &result);          // all the posted calls have been executed
+    std::printf("%-8s %-10s avg %8.3f us  (%d calls)\n", backend, "post", postMicros / posts, posts);
+}
+
+
+int main(int argc, char *argv[])
+{
+    int wrappers = 200;
+    int calls = 20000;
+    int posts = 1000000;
+    for(int i = 1; i < argc; i++){
+        if(!std::strcmp(argv[i], "--wrappers") && i + 1 < argc){
+            wrappers = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(!std::strcmp(argv[i], "--calls") && i + 1 < argc){
+            calls = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(!std::strcmp(argv[i], "--posts") && i + 1 < argc){
+            posts = std::max(1, std::atoi(argv[++i]));
+        }
+        else{
+            std::fprintf(stderr, "usage: processwrapperbench [--wrappers N] [--calls N] [--posts N]\n");
+            return 1;
+        }
+    }
+    ProcessZygote::start();
+    std::printf("%u cpus, shared memory of a process wrapper: %.1f KB\n", std::thread::hardware_concurrency(),
+                sizeof(ProcessChannel) / 1024.0);
+    measure<ProcessWrapper1<BenchObject, int> >("process", wrappers, calls, posts);
+    measure<ThreadWrapper1<BenchObject, int> >("thread", wrappers, calls, posts);
+    return 0;
+}
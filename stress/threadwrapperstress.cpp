@@ -0,0 +1,666 @@
+/*
+
+    The threadwrapperstress program is a long-running stress test of the creation and deletion of the wrappers (the SemaphoreObject
+    handshake, the ThreadObjectTArgX allocations and the T **t handoff), with 3 workloads:
+        churn       many threads create and delete wrappers at once, each wrapper is deleted by a random thread (not always its creator)
+        scale       the live wrappers are increased up to --live (10000 by default), called once each, and deleted by many threads
+        teardown    every wrapper is deleted with a backlog of calls still queued (in both the lanes), so they must be discarded
+    Every second it prints the throughput (creations and deletions per second), the live wrappers, the RSS and the thread count;
+    at the end of each workload it prints the percentiles of the handshake latencies (the constructor and the destructor of the
+    wrapper, which are blocking).
+
+    It fails (exit code 1) on any leak: objects T or posted calls not deleted, threads not ended, or the RSS growing more than
+    --max-rss-growth MB during the steady part of churn and teardown; in the same steady part, it fails also if the blocks of
+    the RecyclingPool (recyclingpool.h) are not recycled, that is if the allocations of the pools reaching the system allocator
+    do not reach a plateau: in the second half of the steady part they must be fewer than the blocks which the workload can
+    legitimately hold at once (its live wrappers with their queued calls, plus the batches of the pools, so it scales with
+    --threads), or at least half as frequent (per creation and deletion) as in the first half. It fails (exit code 2) if a
+    workload makes no progress for --hang-timeout seconds.
+
+    Usage:
+        threadwrapperstress [--workload all|churn|scale|teardown] [--threads N] [--seconds S] [--live N] [--calls N]
+                            [--hang-timeout S] [--max-rss-growth MB]
+
+    Build (from this directory), with the Qt-free backend:
+        g++ -std=c++11 -O2 -DTHREADWRAPPER_STD_BACKEND -I.. threadwrapperstress.cpp -pthread -o threadwrapperstress
+    or, with Qt, in a console project with threadwrapperstress.cpp plus inboxobject.cpp and semaphoreobject.cpp (and their headers).
+    It should be built also at -O0 with a sanitizer, which catches the data races and the missing definitions hidden by the optimizer:
+        g++ -std=c++11 -O0 -g -fsanitize=thread -DTHREADWRAPPER_STD_BACKEND -I.. threadwrapperstress.cpp -pthread -o threadwrapperstress
+    and run with a few wrappers, as the sanitizer is slow and needs a lot of memory (e.g. --live 200 --max-rss-growth 256).
+    RSS and thread count are read from /proc, so they are reported only on Linux.
+
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "threadwrapper.h"
+
+#ifndef THREADWRAPPER_STD_BACKEND
+#include <QCoreApplication>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+
+typedef std::chrono::steady_clock Clock;
+
+
+struct StressCounters
+{
+    std::atomic<long> liveObjects;          // objects T not deleted yet
+    std::atomic<long> liveCalls;            // posted calls not executed or discarded yet
+    std::atomic<long> liveWrappers;
+    std::atomic<uint64_t> operations;       // creations and deletions, the progress seen by the watchdog
+    std::atomic<uint64_t> executedCalls;
+};
+
+static StressCounters counters;
+
+
+class StressObject
+#ifndef THREADWRAPPER_STD_BACKEND
+    : public QObject
+#endif
+{
+
+public:
+    StressObject(){
+        id = 0;
+        calls = 0;
+        counters.liveObjects++;
+    }
+    explicit StressObject(int _id){
+        id = _id;
+        calls = 0;
+        counters.liveObjects++;
+    }
+    ~StressObject(){
+        counters.liveObjects--;
+    }
+
+public:
+    int id;
+    uint64_t calls;
+
+public:
+    void call(){
+        calls++;
+        counters.executedCalls++;
+    }
+
+};
+
+
+class CallProbe
+{
+
+    // carried by every posted call, so the calls discarded by the deletion are counted too
+
+public:
+    CallProbe(){
+        counters.liveCalls++;
+    }
+    CallProbe(const CallProbe &){
+        counters.liveCalls++;
+    }
+    ~CallProbe(){
+        counters.liveCalls--;
+    }
+
+};
+
+
+typedef ThreadWrapper1<StressObject, int> StressWrapper;
+
+
+class LatencyHistogram
+{
+
+    // a log-linear histogram (16 buckets for every power of 2, so the error is below 7%), with a constant memory usage
+
+public:
+    LatencyHistogram(){
+        std::memset(buckets, 0, sizeof(buckets));
+        samples = 0;
+        maximum = 0;
+    }
+
+private:
+    enum {bucketCount = 29 * 16};
+    uint64_t buckets[bucketCount];
+    uint64_t samples;
+    uint32_t maximum;
+
+public:
+    void record(uint32_t micros){
+        buckets[bucketOf(micros)]++;
+        samples++;
+        maximum = std::max(maximum, micros);
+    }
+    void merge(const LatencyHistogram &other){
+        for(int i = 0; i < bucketCount; i++){
+            buckets[i] += other.buckets[i];
+        }
+        samples += other.samples;
+        maximum = std::max(maximum, other.maximum);
+    }
+    void print(const char *workload, const char *handshake) const {
+        if(!samples){
+            return;
+        }
+        static const double ranks[] = {0.5, 0.9, 0.99, 0.999};
+        std::printf("%-9s %s latency (us, %llu samples):", workload, handshake, (unsigned long long)samples);
+        for(int r = 0; r < 4; r++){
+            uint64_t rank = (uint64_t)(samples * ranks[r]);
+            uint64_t seen = 0;
+            int i = 0;
+            while(i < bucketCount - 1 && (seen += buckets[i]) <= rank){
+                i++;
+            }
+            std::printf(" p%g %u", ranks[r] * 100, std::min(maximum, lowerBound(i)));
+        }
+        std::printf(" max %u\n", maximum);
+    }
+
+private:
+    static int bucketOf(uint32_t micros){
+        if(micros < 16){
+            return (int)micros;
+        }
+        int exponent = 31;
+        while(!(micros >> exponent)){
+            exponent--;
+        }
+        return (exponent - 3) * 16 + (int)((micros >> (exponent - 4)) & 15);
+    }
+    static uint32_t lowerBound(int bucket){
+        if(bucket < 16){
+            return (uint32_t)bucket;
+        }
+        return (uint32_t)(16 + bucket % 16) << (bucket / 16 + 3 - 4);
+    }
+
+};
+
+
+class LatencyRecorder
+{
+
+public:
+    void add(const LatencyHistogram &creations, const LatencyHistogram &deletions){
+        std::lock_guard<std::mutex> lock(mutex);
+        creationMicros.merge(creations);
+        deletionMicros.merge(deletions);
+    }
+    void print(const char *workload){
+        std::lock_guard<std::mutex> lock(mutex);
+        creationMicros.print(workload, "create");
+        deletionMicros.print(workload, "delete");
+        creationMicros = LatencyHistogram();
+        deletionMicros = LatencyHistogram();
+    }
+
+private:
+    std::mutex mutex;
+    LatencyHistogram creationMicros;
+    LatencyHistogram deletionMicros;
+
+};
+
+
+class SystemProbe
+{
+
+public:
+    static long rssKilobytes(){
+#if defined(__linux__)
+        FILE *file = std::fopen("/proc/self/statm", "r");
+        long pages = -1;
+        long residentPages = -1;
+        if(file){
+            if(std::fscanf(file, "%ld %ld", &pages, &residentPages) != 2){
+                residentPages = -1;
+            }
+            std::fclose(file);
+        }
+        return residentPages < 0 ? -1 : residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+        return -1;
+#endif
+    }
+    static long threadCount(){
+#if defined(__linux__)
+        FILE *file = std::fopen("/proc/self/status", "r");
+        long threads = -1;
+        char line[256];
+        while(file && std::fgets(line, sizeof(line), file)){
+            if(std::strncmp(line, "Threads:", 8) == 0){
+                threads = std::atol(line + 8);
+                break;
+            }
+        }
+        if(file){
+            std::fclose(file);
+        }
+        return threads;
+#else
+        return -1;
+#endif
+    }
+
+};
+
+
+struct SteadySample
+{
+    // taken at the end of the warm-up, in the middle and at the end of the steady part of a workload
+
+    long rssKilobytes;
+    uint64_t poolAllocations;           // RecyclingPool::statistics().systemAllocations
+    uint64_t operations;
+
+    static SteadySample take(){
+        SteadySample sample;
+        sample.rssKilobytes = SystemProbe::rssKilobytes();
+        sample.poolAllocations = RecyclingPool::statistics().systemAllocations;
+        sample.operations = counters.operations.load();
+        return sample;
+    }
+};
+
+
+struct StressOptions
+{
+    std::string workload;
+    int threads;
+    int seconds;
+    int live;
+    int calls;
+    int hangTimeout;
+    long maxRssGrowth;          // MB
+};
+
+
+class StressHarness
+{
+
+public:
+    explicit StressHarness(const StressOptions &_options){
+        options = _options;
+        failed = false;
+        finished.store(false);
+        currentWorkload.store("startup");
+        baselineThreads = -1;
+        start = Clock::now();
+    }
+
+private:
+    StressOptions options;
+    LatencyRecorder latencies;
+    std::atomic<const char*> currentWorkload;
+    std::atomic<bool> finished;
+    long baselineThreads;           // the threads at the start of the current workload
+    Clock::time_point start;
+    bool failed;
+
+private:
+    enum {poolBatchSize = 32};      // the blocks of another thread a thread keeps before giving them back (see RecyclingPool)
+    enum {wrapperBlocks = 8};       // more than the lifecycle blocks of a wrapper (ThreadObjectTArgX, SemaphoreObject, ...)
+    enum {maxBacklog = 2000};       // the calls queued by teardown before a deletion
+
+public:
+    int run(){
+        std::thread monitor(&StressHarness::monitor, this);
+        bool all = options.workload == "all";
+        if(all || options.workload == "churn"){
+            churn();
+        }
+        if(all || options.workload == "scale"){
+            scale();
+        }
+        if(all || options.workload == "teardown"){
+            teardown();
+        }
+        finished.store(true);
+        monitor.join();
+        std::printf("%s\n", failed ? "FAILED" : "PASSED");
+        return failed ? 1 : 0;
+    }
+
+private:
+    void churn(){
+        // the wrappers are shared between the threads, so many of them are deleted by a thread which did not create them
+        beginWorkload("churn");
+        std::mutex poolMutex;
+        std::vector<StressWrapper*> pool;
+        size_t poolLimit = (size_t)options.threads * 4;
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(options.seconds);
+        Clock::time_point warm = Clock::now() + std::chrono::seconds(options.seconds) / 4;
+        std::vector<std::thread> workers;
+        for(int w = 0; w < options.threads; w++){
+            workers.push_back(std::thread([this, w, &pool, &poolMutex, poolLimit, deadline](){
+                std::minstd_rand random(w + 1);
+                LatencyHistogram creations;
+                LatencyHistogram deletions;
+                while(Clock::now() < deadline){
+                    StressWrapper *wrapper = 0;
+                    bool create = random() % 2 == 0;
+                    bool full = false;
+                    {
+                        std::lock_guard<std::mutex> lock(poolMutex);
+                        if(!create && !pool.empty()){
+                            size_t index = random() % pool.size();
+                            wrapper = pool[index];
+                            pool[index] = pool.back();
+                            pool.pop_back();
+                        }
+                        else if(pool.size() >= poolLimit){
+                            full = true;
+                        }
+                    }
+                    if(full){
+                        std::this_thread::yield();          // the other workers must delete some wrappers first
+                    }
+                    else if(wrapper){
+                        destroy(wrapper, deletions);
+                    }
+                    else{
+                        wrapper = createAndCall(w, creations);
+                        std::lock_guard<std::mutex> lock(poolMutex);
+                        pool.push_back(wrapper);
+                    }
+                }
+                latencies.add(creations, deletions);
+            }));
+        }
+        std::this_thread::sleep_until(warm);
+        SteadySample warmSample = SteadySample::take();
+        std::this_thread::sleep_until(warm + (deadline - warm) / 2);
+        SteadySample middleSample = SteadySample::take();
+        std::this_thread::sleep_until(deadline);
+        SteadySample endSample = SteadySample::take();
+        for(size_t w = 0; w < workers.size(); w++){
+            workers[w].join();
+        }
+        LatencyHistogram deletions;
+        for(size_t i = 0; i < pool.size(); i++){
+            destroy(pool[i], deletions);
+        }
+        latencies.add(LatencyHistogram(), deletions);
+        uint64_t heldBlocks = poolLimit * (options.calls + wrapperBlocks) + (uint64_t)options.threads * poolBatchSize;
+        finishWorkload("churn", &warmSample, &middleSample, &endSample, heldBlocks);
+    }
+    void scale(){
+        // the live wrappers grow up to options.live, then every object is called once, then they are deleted by many threads
+        beginWorkload("scale");
+        std::vector<StressWrapper*> wrappers(options.live, (StressWrapper*)0);
+        std::atomic<int> nextIndex(0);
+        std::atomic<bool> limitReached(false);
+        runWorkers([this, &wrappers, &nextIndex, &limitReached](int w){
+            LatencyHistogram creations;
+            int index;
+            while(!limitReached.load() && (index = nextIndex++) < (int)wrappers.size()){
+                try{
+                    wrappers[index] = createAndCall(index, creations);
+                }
+                catch(const std::system_error &error){
+                    if(!limitReached.exchange(true)){
+                        std::printf("scale     cannot create more threads (%s)\n", error.what());
+                    }
+                }
+            }
+            latencies.add(creations, LatencyHistogram());
+            (void)w;
+        });
+        long live = counters.liveWrappers.load();
+        std::printf("scale     peak: %ld live wrappers, %ld threads, rss %.1f MB\n", live, SystemProbe::threadCount(),
+                    SystemProbe::rssKilobytes() / 1024.0);
+        if(live < options.live){
+            std::printf("scale     only %ld of %d wrappers created (check the thread and memory limits)\n", live, options.live);
+            failed = true;
+        }
+        uint64_t executed = 0;
+        for(size_t i = 0; i < wrappers.size(); i++){
+            if(wrappers[i]){
+                wrappers[i]->invokeSync([&executed](StressObject *object){ executed += object->calls; });
+                counters.operations++;
+            }
+        }
+        if(executed != (uint64_t)live * options.calls){
+            std::printf("scale     %llu calls executed, %llu expected\n", (unsigned long long)executed,
+                        (unsigned long long)live * options.calls);
+            failed = true;
+        }
+        nextIndex.store(0);
+        runWorkers([this, &wrappers, &nextIndex](int){
+            LatencyHistogram deletions;
+            int index;
+            while((index = nextIndex++) < (int)wrappers.size()){
+                if(wrappers[index]){
+                    destroy(wrappers[index], deletions);
+                }
+            }
+            latencies.add(LatencyHistogram(), deletions);
+        });
+        finishWorkload("scale", 0, 0, 0, 0);
+    }
+    void teardown(){
+        // every wrapper is deleted just after a burst of calls, so most of them are still queued and must be discarded
+        beginWorkload("teardown");
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(options.seconds);
+        Clock::time_point warm = Clock::now() + std::chrono::seconds(options.seconds) / 4;
+        SteadySample warmSample;
+        SteadySample middleSample;
+        SteadySample endSample;
+        std::thread warmProbe([&warmSample, &middleSample, &endSample, warm, deadline](){
+            std::this_thread::sleep_until(warm);
+            warmSample = SteadySample::take();
+            std::this_thread::sleep_until(warm + (deadline - warm) / 2);
+            middleSample = SteadySample::take();
+            std::this_thread::sleep_until(deadline);
+            endSample = SteadySample::take();
+        });
+        runWorkers([this, deadline](int w){
+            std::minstd_rand random(w + 1);
+            LatencyHistogram creations;
+            LatencyHistogram deletions;
+            while(Clock::now() < deadline){
+                StressWrapper *wrapper = createAndCall(w, creations);
+                int backlog = (int)(random() % maxBacklog);
+                CallProbe probe;
+                for(int i = 0; i < backlog; i++){
+                    wrapper->post([probe](StressObject *object){ object->call(); }, i % 16 == 0 ? UrgentLane : BulkLane);
+                }
+                destroy(wrapper, deletions);
+            }
+            latencies.add(creations, deletions);
+        });
+        warmProbe.join();
+        uint64_t heldBlocks = (uint64_t)options.threads * (maxBacklog + options.calls + wrapperBlocks + poolBatchSize);
+        finishWorkload("teardown", &warmSample, &middleSample, &endSample, heldBlocks);
+    }
+
+private:
+    StressWrapper *createAndCall(int id, LatencyHistogram &creations){
+        Clock::time_point before = Clock::now();
+        StressWrapper *wrapper = new StressWrapper(id);
+        creations.record(microsSince(before));
+        counters.liveWrappers++;
+        counters.operations++;
+        CallProbe probe;
+        for(int i = 0; i < options.calls; i++){
+            wrapper->post([probe](StressObject *object){ object->call(); });
+        }
+        return wrapper;
+    }
+    void destroy(StressWrapper *wrapper, LatencyHistogram &deletions){
+        Clock::time_point before = Clock::now();
+        delete wrapper;
+        deletions.record(microsSince(before));
+        counters.liveWrappers--;
+        counters.operations++;
+    }
+    template <class Worker>
+    void runWorkers(Worker worker){
+        std::vector<std::thread> workers;
+        for(int w = 0; w < options.threads; w++){
+            workers.push_back(std::thread(worker, w));
+        }
+        for(size_t w = 0; w < workers.size(); w++){
+            workers[w].join();
+        }
+    }
+    void beginWorkload(const char *workload){
+        currentWorkload.store(workload);
+        baselineThreads = SystemProbe::threadCount();
+    }
+    void finishWorkload(const char *workload, const SteadySample *warm, const SteadySample *middle, const SteadySample *steadyEnd,
+                        uint64_t heldBlocks){
+        latencies.print(workload);
+        // the deletion is blocking, so after the last delete everything must have been freed already
+        if(counters.liveObjects.load() != 0 || counters.liveCalls.load() != 0 || counters.liveWrappers.load() != 0){
+            std::printf("%-9s LEAK: %ld objects, %ld calls, %ld wrappers still alive\n", workload, counters.liveObjects.load(),
+                        counters.liveCalls.load(), counters.liveWrappers.load());
+            failed = true;
+        }
+        long threads = SystemProbe::threadCount();
+        for(int retry = 0; retry < 100 && threads > baselineThreads; retry++){
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));         // the kernel can be a bit late with the exited threads
+            threads = SystemProbe::threadCount();
+        }
+        if(threads > baselineThreads){
+            std::printf("%-9s LEAK: %ld threads, %ld at the start\n", workload, threads, baselineThreads);
+            failed = true;
+        }
+        long rss = SystemProbe::rssKilobytes();
+        if(warm && warm->rssKilobytes >= 0 && rss >= 0){
+            long growth = (rss - warm->rssKilobytes) / 1024;
+            std::printf("%-9s rss growth after warm-up: %ld MB\n", workload, growth);
+            if(growth > options.maxRssGrowth){
+                std::printf("%-9s LEAK: the rss has grown by %ld MB (limit %ld MB)\n", workload, growth, options.maxRssGrowth);
+                failed = true;
+            }
+        }
+        if(warm && middle && steadyEnd && middle->operations > warm->operations && steadyEnd->operations > middle->operations){
+            // the blocks freed by the deletions must be reused by the next creations, so the pools stop growing; how fast they reach
+            // their plateau depends on the threads and on the speed of the machine, so we compare the two halves of the steady part
+            uint64_t firstOperations = middle->operations - warm->operations;
+            uint64_t firstAllocations = middle->poolAllocations - warm->poolAllocations;
+            uint64_t secondOperations = steadyEnd->operations - middle->operations;
+            uint64_t secondAllocations = steadyEnd->poolAllocations - middle->poolAllocations;
+            std::printf("%-9s pool system allocations after warm-up: %llu in %llu operations, then %llu in %llu operations\n",
+                        workload, (unsigned long long)firstAllocations, (unsigned long long)firstOperations,
+                        (unsigned long long)secondAllocations, (unsigned long long)secondOperations);
+            if(secondAllocations > heldBlocks && secondAllocations * firstOperations * 2 > firstAllocations * secondOperations){
+                std::printf("%-9s LEAK: the pools are not recycling their blocks (more than %llu allocations, at more than half"
+                            " the rate of the first half)\n", workload, (unsigned long long)heldBlocks);
+                failed = true;
+            }
+        }
+        std::printf("%-9s %llu calls executed so far\n", workload, (unsigned long long)counters.executedCalls.load());
+        std::fflush(stdout);
+    }
+    void monitor(){
+        // it prints the statistics every second, and it ends the program if a workload makes no progress
+        uint64_t lastOperations = counters.operations.load();
+        Clock::time_point lastProgress = Clock::now();
+        long startRss = SystemProbe::rssKilobytes();
+        while(!finished.load()){
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            uint64_t operations = counters.operations.load();
+            long rss = SystemProbe::rssKilobytes();
+            std::printf("[%6.1fs] %-9s %8llu ops/s  %6ld live  rss %7.1f MB (%+.1f)  %6ld threads\n",
+                        std::chrono::duration<double>(Clock::now() - start).count(), currentWorkload.load(),
+                        (unsigned long long)(operations - lastOperations), counters.liveWrappers.load(), rss / 1024.0,
+                        (rss - startRss) / 1024.0, SystemProbe::threadCount());
+            std::fflush(stdout);
+            if(operations != lastOperations){
+                lastOperations = operations;
+                lastProgress = Clock::now();
+            }
+            else if(Clock::now() - lastProgress > std::chrono::seconds(options.hangTimeout)){
+                std::printf("HANG: no progress for %d seconds in %s (%ld live wrappers, %ld objects, %ld calls)\n",
+                            options.hangTimeout, currentWorkload.load(), counters.liveWrappers.load(),
+                            counters.liveObjects.load(), counters.liveCalls.load());
+                std::fflush(stdout);
+                std::_Exit(2);
+            }
+        }
+    }
+    static uint32_t microsSince(Clock::time_point before){
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - before).count();
+    }
+
+};
+
+
+static bool parseOptions(int argc, char *argv[], StressOptions &options){
+    options.workload = "all";
+    options.threads = std::max(4, (int)std::thread::hardware_concurrency() * 2);
+    options.seconds = 10;
+    options.live = 10000;
+    options.calls = 16;
+    options.hangTimeout = 30;
+    options.maxRssGrowth = 16;
+    for(int i = 1; i < argc; i++){
+        std::string option = argv[i];
+        if(i + 1 >= argc){
+            return false;
+        }
+        std::string value = argv[++i];
+        if(option == "--workload" && (value == "all" || value == "churn" || value == "scale" || value == "teardown")){
+            options.workload = value;
+        }
+        else if(option == "--threads"){
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        }
+        else if(option == "--seconds"){
+            options.seconds = std::max(1, std::atoi(value.c_str()));
+        }
+        else if(option == "--live"){
+            options.live = std::max(1, std::atoi(value.c_str()));
+        }
+        else if(option == "--calls"){
+            options.calls = std::max(0, std::atoi(value.c_str()));
+        }
+        else if(option == "--hang-timeout"){
+            options.hangTimeout = std::max(1, std::atoi(value.c_str()));
+        }
+        else if(option == "--max-rss-growth"){
+            options.maxRssGrowth = std::max(0L, std::atol(value.c_str()));
+        }
+        else{
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int main(int argc, char *argv[]){
+#ifndef THREADWRAPPER_STD_BACKEND
+    QCoreApplication application(argc, argv);          // the wrapped objects live in their own threads, so exec() is not needed
+#endif
+    StressOptions options;
+    if(!parseOptions(argc, argv, options)){
+        std::fprintf(stderr, "usage: %s [--workload all|churn|scale|teardown] [--threads N] [--seconds S] [--live N] [--calls N]"
+                             " [--hang-timeout S] [--max-rss-growth MB]\n", argv[0]);
+        return 3;
+    }
+    StressHarness harness(options);
+    return harness.run();
+}
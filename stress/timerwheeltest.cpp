@@ -0,0 +1,261 @@
+/*
+
+    The timerwheeltest program checks the TimerWheel (timerwheel.h) in two steps.
+
+    The first step is deterministic: a wheel with a manual clock (overriding currentTick()) is driven by jumping the clock to
+    nextExpiryTick(), so it covers all the levels in a moment. The timers have delays at the edges of every level (2^8, 2^14, 2^20
+    and 2^26 ticks), random delays up to 2^27 ticks and random re-arms from the callbacks, starting from --rounds (4 by default)
+    different ticks; every timer must expire exactly at its tick, and the timers beyond 2^26 ticks at the last tick of the wheel.
+
+    The second step checks the lateness with the real clock: it schedules --timers timers (2000 by default) with random delays up
+    to --max-delay milliseconds (2000 by default, so the timers are spread over level0 and the first upper level), some of them
+    re-armed or cancelled by the callbacks of the other ones, then it drives the wheel like the event loop of a thread (sleeping
+    nextTimeout() milliseconds and calling advance()). For every timer it measures the lateness, from the time it was due to the
+    time its callback was called; at the end it prints the percentiles of the lateness. With a long --max-delay the lateness
+    mostly measures the scheduling of the process, the deterministic step is the one checking the upper levels.
+
+    It fails (exit code 1) if a timer of the first step does not expire exactly at its tick, or if a timer of the second step
+    expires early (by more than a tick of 1 millisecond, the granularity of the wheel), more than --max-lateness milliseconds
+    (20 by default) late, or does not expire at all.
+
+    Usage:
+        timerwheeltest [--rounds N] [--timers N] [--max-delay MS] [--max-lateness MS] [--seed N]
+
+    Build (from this directory):
+        g++ -std=c++11 -O2 -DTHREADWRAPPER_STD_BACKEND -I.. timerwheeltest.cpp -o timerwheeltest
+
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "timerwheel.h"
+
+
+struct TestTimer
+{
+    TimerWheelEntry entry;
+    std::chrono::steady_clock::time_point due;
+    bool cancelled;
+    bool fired;
+    bool early;
+    int lateness;           // in microseconds
+};
+
+
+class ManualTimerWheel : public TimerWheel
+{
+
+public:
+    ManualTimerWheel(){
+        now = 0;
+    }
+
+public:
+    uint64_t now;
+
+protected:
+    uint64_t currentTick() const {
+        return now;
+    }
+
+};
+
+
+struct TickTimer
+{
+    TimerWheelEntry entry;
+    uint64_t due;
+    uint64_t latestDue;     // equal to due, but one tick later for a clamped timer (it depends on the ticks already processed)
+    uint64_t firedAt;
+    int fired;
+};
+
+
+static void arm(ManualTimerWheel &wheel, TickTimer *timer, int delay){
+    timer->due = wheel.now + (uint64_t)delay;
+    timer->latestDue = timer->due;
+    if(delay >= (1 << 26)){
+        timer->due = wheel.now + (1 << 26) - 1;
+        timer->latestDue = std::min(wheel.now + (uint64_t)delay, wheel.now + (1 << 26));
+    }
+    timer->fired = 0;
+    timer->firedAt = 0;
+    wheel.schedule(&timer->entry, delay);
+}
+
+
+static int checkLevels(int rounds, std::mt19937 &random){
+    // returns the number of the timers which have not expired exactly at their tick
+    static const int edges[] = {1, 255, 256, 257, 16383, 16384, 16385, (1 << 20) - 1, 1 << 20, (1 << 20) + 1,
+                                (1 << 26) - 1, 1 << 26, (1 << 26) + 1, 1 << 27, 0x7fffffff};
+    int edgeCount = (int)(sizeof(edges) / sizeof(edges[0]));
+    std::uniform_int_distribution<int> delays(0, 1 << 27);
+    std::uniform_int_distribution<int> actions(0, 7);
+    int wrong = 0;
+    int fired = 0;
+    for(int round = 0; round < rounds; round++){
+        ManualTimerWheel wheel;
+        wheel.now = random() % (1 << 27);           // the position in every level is different in each round
+        std::vector<std::unique_ptr<TickTimer> > timers;
+        for(int i = 0; i < edgeCount + 1000; i++){
+            timers.push_back(std::unique_ptr<TickTimer>(new TickTimer()));
+        }
+        for(size_t i = 0; i < timers.size(); i++){
+            TickTimer *timer = timers[i].get();
+            TickTimer *other = timers[random() % timers.size()].get();
+            int action = actions(random);
+            int otherDelay = delays(random);
+            timer->entry.callback = [timer, other, action, otherDelay, &wheel](){
+                timer->fired++;
+                timer->firedAt = wheel.now;
+                if(action == 0 && other != timer && !other->fired){
+                    arm(wheel, other, otherDelay);          // a callback re-arming another timer
+                }
+            };
+            arm(wheel, timer, i < (size_t)edgeCount ? edges[i] : delays(random));
+        }
+        uint64_t limit = wheel.now + (1ULL << 28);         // later than any timer, even a re-armed one
+        while(wheel.count() > 0 && wheel.now < limit){
+            wheel.now = std::max(wheel.now, wheel.nextExpiryTick());
+            wheel.advance();
+        }
+        for(size_t i = 0; i < timers.size(); i++){
+            TickTimer *timer = timers[i].get();
+            if(timer->fired != 1 || timer->firedAt < timer->due || timer->firedAt > timer->latestDue){
+                if(wrong < 10){
+                    std::printf("round %d, timer %d: fired %d times, at %llu instead of %llu\n", round, (int)i, timer->fired,
+                                (unsigned long long)timer->firedAt, (unsigned long long)timer->due);
+                }
+                wrong++;
+            }
+            fired += timer->fired;
+        }
+    }
+    std::printf("levels: %d rounds, %d timers fired, %d wrong\n", rounds, fired, wrong);
+    return wrong;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int rounds = 4;
+    int timerCount = 2000;
+    int maxDelay = 2000;
+    int maxLateness = 20;
+    unsigned seed = (unsigned)std::chrono::steady_clock::now().time_since_epoch().count();
+    for(int i = 1; i < argc; i++){
+        if(!std::strcmp(argv[i], "--rounds") && i + 1 < argc){
+            rounds = std::atoi(argv[++i]);
+        }
+        else if(!std::strcmp(argv[i], "--timers") && i + 1 < argc){
+            timerCount = std::atoi(argv[++i]);
+        }
+        else if(!std::strcmp(argv[i], "--max-delay") && i + 1 < argc){
+            maxDelay = std::atoi(argv[++i]);
+        }
+        else if(!std::strcmp(argv[i], "--max-lateness") && i + 1 < argc){
+            maxLateness = std::atoi(argv[++i]);
+        }
+        else if(!std::strcmp(argv[i], "--seed") && i + 1 < argc){
+            seed = (unsigned)std::strtoul(argv[++i], 0, 10);
+        }
+        else{
+            std::fprintf(stderr, "usage: timerwheeltest [--rounds N] [--timers N] [--max-delay MS] [--max-lateness MS] [--seed N]\n");
+            return 1;
+        }
+    }
+    std::printf("seed %u\n", seed);
+
+    std::mt19937 random(seed);
+    if(checkLevels(rounds, random)){
+        std::printf("FAILED\n");
+        return 1;
+    }
+
+    std::printf("timers %d, delays up to %d ms\n", timerCount, maxDelay);
+    std::uniform_int_distribution<int> delays(0, maxDelay);
+    std::uniform_int_distribution<int> actions(0, 15);
+    TimerWheel wheel;
+    std::vector<std::unique_ptr<TestTimer> > timers;
+    for(int i = 0; i < timerCount; i++){
+        timers.push_back(std::unique_ptr<TestTimer>(new TestTimer()));
+    }
+    for(int i = 0; i < timerCount; i++){
+        TestTimer *timer = timers[i].get();
+        TestTimer *other = timers[random() % timerCount].get();
+        int action = actions(random);
+        int otherDelay = delays(random) / 2;
+        timer->cancelled = false;
+        timer->fired = false;
+        timer->early = false;
+        timer->lateness = 0;
+        timer->entry.callback = [timer, other, action, otherDelay, &wheel](){
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            timer->fired = true;
+            timer->early = now + std::chrono::milliseconds(wheel.tick()) < timer->due;
+            timer->lateness = (int)std::chrono::duration_cast<std::chrono::microseconds>(now - timer->due).count();
+            if(other == timer || other->fired || other->cancelled){
+                return;
+            }
+            if(action == 0){
+                other->entry.cancel();              // a callback cancelling another timer
+                other->cancelled = true;
+            }
+            else if(action == 1){
+                other->due = std::chrono::steady_clock::now() + std::chrono::milliseconds(otherDelay);
+                wheel.schedule(&other->entry, otherDelay);          // a callback re-arming another timer
+            }
+        };
+        int delay = delays(random);
+        timer->due = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+        wheel.schedule(&timer->entry, delay);
+    }
+
+    std::chrono::steady_clock::time_point limit = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxDelay * 3 + 1000);
+    while(wheel.count() > 0 && std::chrono::steady_clock::now() < limit){
+        int timeout = wheel.nextTimeout();
+        if(timeout > 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+        wheel.advance();
+    }
+
+    std::vector<int> lateness;
+    int early = 0;
+    int late = 0;
+    int missing = 0;
+    for(int i = 0; i < timerCount; i++){
+        TestTimer *timer = timers[i].get();
+        if(timer->cancelled){
+            continue;
+        }
+        if(!timer->fired){
+            missing++;
+            continue;
+        }
+        early += timer->early ? 1 : 0;
+        late += timer->lateness > maxLateness * 1000 ? 1 : 0;
+        lateness.push_back(timer->lateness);
+    }
+    std::sort(lateness.begin(), lateness.end());
+    if(!lateness.empty()){
+        std::printf("lateness: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", lateness[lateness.size() / 2] / 1000.0,
+                    lateness[lateness.size() * 99 / 100] / 1000.0, lateness.back() / 1000.0);
+    }
+    std::printf("fired %d, early %d, late %d, missing %d\n", (int)lateness.size(), early, late, missing);
+    if(early || late || missing){
+        std::printf("FAILED\n");
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+
+    The SyncCallSlot and SyncCallGraph classes are used by ThreadWrapperX::invokeSync() (in both the Qt and the Qt-free versions),
+    to call a callable on the object T inside its thread and wait for its completion, without Qt::BlockingQueuedConnection.
+
+    SyncCallSlot is pre-allocated inside the wrapper: the caller stores a pointer to its callable in the slot (no copy and no
+    allocation), then it spins for a few microseconds waiting for the completion, and only after that it parks on a futex; the
+    thread of T wakes it only if it is actually parked. The callers of the same wrapper are serialized by the mutex of the slot.
+    If the callable throws an exception, it is caught inside the thread of T (so the caller is still woken up) and invokeSync()
+    throws it again in the caller thread.
+
+    SyncCallEnvelope is the pre-allocated envelope which carries the slot to the thread of T.
+
+    SyncCallGraph keeps the "waits for" edges between the threads blocked in invokeSync(): before blocking, a caller checks that
+    the target thread is not (directly or through other threads) waiting for the caller thread itself, because in this case the
+    call would never be executed (a deadlock); invokeSync() then returns false without executing the callable.
+
+*/
+
+
+#ifndef SYNCCALL_H
+#define SYNCCALL_H
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "callenvelope.h"
+#include "futex.h"
+
+
+class SyncCallSlot
+{
+
+public:
+    SyncCallSlot(){
+        state.store(Idle);
+        invoker = 0;
+        functor = 0;
+        executed = false;
+    }
+
+public:
+    std::mutex callerMutex;
+
+private:
+    enum State {Idle, Posted, Parked, Done};
+    std::atomic<int> state;
+    void (*invoker)(void *, void *);
+    void *functor;
+    bool executed;
+    std::exception_ptr error;
+
+public:
+    template <class T, class Functor>
+    void prepare(Functor *_functor){
+        invoker = &invoke<T, Functor>;
+        functor = _functor;
+        state.store(Posted, std::memory_order_relaxed);      // the post of the slot to the thread publishes these values
+    }
+    void run(void *object){
+        // called inside the thread of the object
+        try{
+            invoker(functor, object);
+        }
+        catch(...){
+            error = std::current_exception();       // for the caller, which is waiting anyway
+        }
+        executed = true;
+        complete();
+    }
+    void discard(){
+        executed = false;
+        complete();
+    }
+    bool wait(){
+        // returns true if the functor has been executed
+        static const bool spinning = std::thread::hardware_concurrency() > 1;        // spinning on a single cpu only delays the callee
+        if(spinning){
+            // the spin is bounded by time, as the cost of a pause instruction goes from a few cycles to more than 100 between cpus
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spinMicroseconds);
+            for(int i = 1; ; i++){
+                if(state.load(std::memory_order_acquire) == Done){
+                    state.store(Idle, std::memory_order_relaxed);
+                    return executed;
+                }
+                cpuRelax();
+                if(!(i & 31) && std::chrono::steady_clock::now() >= deadline){
+                    break;
+                }
+            }
+        }
+        int expected = Posted;
+        if(state.compare_exchange_strong(expected, Parked, std::memory_order_acq_rel)){
+            while(state.load(std::memory_order_acquire) != Done){
+                futexWait(&state, Parked);
+            }
+        }
+        state.store(Idle, std::memory_order_relaxed);
+        return executed;
+    }
+    std::exception_ptr takeError(){
+        // called by the caller after wait(): the exception thrown by the functor, if any
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        return thrown;
+    }
+
+private:
+    void complete(){
+        if(state.exchange(Done, std::memory_order_acq_rel) == Parked){
+            futexWake(&state, 1);
+        }
+    }
+
+private:
+    enum {spinMicroseconds = 5};          // about the cost of a futex wait and wake
+    template <class T, class Functor>
+    static void invoke(void *_functor, void *object){
+        (*static_cast<Functor*>(_functor))(static_cast<T*>(object));
+    }
+    static void cpuRelax(){
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+private:
+    SyncCallSlot(const SyncCallSlot &);
+    SyncCallSlot &operator=(const SyncCallSlot &);
+
+};
+
+
+template <class T>
+class SyncCallEnvelope : public CallEnvelope
+{
+
+public:
+    explicit SyncCallEnvelope(T **_t){
+        t = _t;
+    }
+
+public:
+    SyncCallSlot slot;
+
+private:
+    T **t;
+
+public:
+    void run(){
+        slot.run(*t);
+    }
+    void release(){
+        // the envelope is a member of the wrapper, so it is reused by every invokeSync()
+    }
+    void discard(){
+        slot.discard();
+    }
+
+};
+
+
+class SyncCallGraph
+{
+
+public:
+    static bool enter(const void *caller, const void *target){
+        std::lock_guard<std::mutex> lock(mutex());
+        std::unordered_map<const void*, const void*> &edges = waitsFor();
+        const void *thread = target;
+        while(thread){
+            if(thread == caller){
+                return false;           // the target is waiting for the caller: blocking would be a deadlock
+            }
+            std::unordered_map<const void*, const void*>::const_iterator edge = edges.find(thread);
+            thread = edge == edges.end() ? 0 : edge->second;
+        }
+        edges[caller] = target;
+        return true;
+    }
+    static void leave(const void *caller){
+        std::lock_guard<std::mutex> lock(mutex());
+        waitsFor().erase(caller);
+    }
+
+private:
+    static std::mutex &mutex(){
+        static std::mutex graphMutex;
+        return graphMutex;
+    }
+    static std::unordered_map<const void*, const void*> &waitsFor(){
+        static std::unordered_map<const void*, const void*> edges;
+        return edges;
+    }
+
+};
+
+
+#endif // SYNCCALL_H
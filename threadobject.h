@@ -23,28 +23,40 @@
 #include <QThread>
 #include <QSemaphore>
 #include <QTimer>
+#include "inboxobject.h"
+#include "recyclingpool.h"
 #include "semaphoreobject.h"
 
 
 template <class T>
-class ThreadObjectTArg0: public QThread
+class ThreadObjectTArg0: public QThread, public RecyclingAllocated
 {
 
 public:
     ThreadObjectTArg0(T **_t, SemaphoreObject *_semaphoreObject){
         t = _t;
         semaphoreObjectReceived = _semaphoreObject;
+        semaphoreObject = 0;
+        // the blocks of the objects living inside the thread are allocated here, in the pools of the creating thread, because
+        // the pools of the new thread end with it, so they could never recycle them
+        semaphoreObjectBlock = RecyclingPool::allocate(sizeof(SemaphoreObject));
+        inboxObjectBlock = RecyclingPool::allocate(sizeof(InboxObject));
     }
     ~ThreadObjectTArg0(){
-        delete semaphoreObject;
+        delete semaphoreObject;         // and the inboxObject, its child
+        RecyclingPool::deallocate(semaphoreObjectBlock);        // if the thread has never run
+        RecyclingPool::deallocate(inboxObjectBlock);
     }
 
 public:
     T **t;
+    InboxObject *inboxObject;
 
 private:
     SemaphoreObject *semaphoreObjectReceived;
     SemaphoreObject *semaphoreObject;
+    void *semaphoreObjectBlock;         // 0 once the semaphoreObject has been constructed in it
+    void *inboxObjectBlock;
 
 protected:
     void run(){
@@ -61,15 +73,23 @@ protected:
         // we use semaphoreObject instead of simple semaphores because (as we can see in a few rows) we need to use a slot,
         // so we need to use a QObject; moreover the slot needs to stay inside this thread, so here's why we need to call
         // the constructor at this point
-        semaphoreObject = new SemaphoreObject(semaphoreObjectReceived->semaphoreCreation, semaphoreObjectReceived->semaphoreDeletion);
+        semaphoreObject = new (semaphoreObjectBlock) SemaphoreObject(semaphoreObjectReceived->semaphoreCreation, semaphoreObjectReceived->semaphoreDeletion);
+        semaphoreObjectBlock = 0;
         // now we say to the semaphoreObject to release a resource for the semaphoreCreation, and as the resource must be released
         // after the exec() command, we use the QMetaObject::invokeMethod with QueuedConnection
         QMetaObject::invokeMethod(semaphoreObject, "releaseResourceForSemaphoreCreation", Qt::QueuedConnection);
+        // the inbox for the calls posted to t must stay inside this thread too; as a child of the semaphoreObject, it is deleted with it
+        inboxObject = new (inboxObjectBlock) InboxObject(semaphoreObject);
+        inboxObjectBlock = 0;
     }
     void createConnections(){
         QObject *objectT = dynamic_cast<QObject*>(*t);   /* useful, because during the destruction it must advise semaphoreObject on releasing
                                                             a resource for the semaphoreDeletion */
-        connect(objectT, SIGNAL(destroyed()), semaphoreObject, SLOT(releaseResourceForSemaphoreDeletion()), Qt::QueuedConnection);
+        inboxObject->setObjectT(objectT);       // the calls posted after the deletion of objectT are discarded
+        // the resource is released directly during the deletion of objectT (a queued release would wait behind all the pending
+        // events of the thread); it is safe because after the acquire the wrapper only stops the thread and waits for its end, so
+        // it returns only when the destruction of objectT is complete
+        connect(objectT, SIGNAL(destroyed()), semaphoreObject, SLOT(releaseResourceForSemaphoreDeletion()), Qt::DirectConnection);
     }
 
 public slots:
@@ -33,19 +33,30 @@
 #ifndef THREADWRAPPER_H
 #define THREADWRAPPER_H
 
-#include "threadobjectt.h"
+#ifdef THREADWRAPPER_STD_BACKEND
+
+#include "stdthreadwrapper.h"          // the Qt-free version of the classes, see stdthreadwrapper.h
+
+#else
+
+#include <mutex>
+#include "callenvelope.h"
+#include "synccall.h"
+#include "threadobject.h"
 
 template <class T>
 class ThreadWrapper0
 {
 
 public:
-    ThreadWrapper0(QThread::Priority _threadPriority = QThread::InheritPriority){
+    ThreadWrapper0(QThread::Priority _threadPriority = QThread::InheritPriority) :
+      syncCallEnvelope(&t_){
         initialize(_threadPriority, true);
     }
 
 protected:
-    ThreadWrapper0(QThread::Priority _threadPriority, bool _enabled){
+    ThreadWrapper0(QThread::Priority _threadPriority, bool _enabled) :
+      syncCallEnvelope(&t_){
         initialize(_threadPriority, _enabled);
     }
 
@@ -74,6 +85,7 @@ protected:
     QThread *thread;
     QThread::Priority threadPriority;
     bool enabled0;
+    SyncCallEnvelope<T> syncCallEnvelope;
 
 protected:
     void createThreadObject(){
@@ -83,9 +95,8 @@ protected:
         semaphoreObject.acquireResourceForSemaphoreCreation();          // we wait the resource release for semaphoreCreation from the semaphoreObject inside the thread
     }
     void deleteThreadObject(){
-        QObject *objectT = dynamic_cast<QObject*>(t_);
-        // now we send a deletion signal to the objectT, so we use the QTimer::singleShot(...)
-        QTimer::singleShot(0, objectT, SLOT(deleteLater()));
+        // now we send a deletion request to the objectT through the urgent lane of the inbox, so it does not wait for the pending calls
+        inbox()->postDeletion();
         this->semaphoreObject.acquireResourceForSemaphoreDeletion();            // we wait the resource release for semaphoreDeletion from the semaphoreObject inside the thread
         thread->quit();     // we inform the thread to stop hisself
         thread->wait();     // then we wait the end of the event loop
@@ -95,6 +106,48 @@ protected:
 public:
     T* t() const {return t_;}
 
+public:
+    template <class Functor>
+    void post(Functor functor, CallLane lane = BulkLane){
+        // the functor is called inside the thread of t_ (with t_ as argument), after the calls already posted to the same lane
+        T *objectT = t_;
+        inbox()->post([functor, objectT]() mutable { functor(objectT); }, lane);
+    }
+    template <class Functor>
+    bool invokeSync(Functor functor, CallLane lane = BulkLane){
+        // the functor is called inside the thread of t_ (with t_ as argument), and we wait for its completion; it returns false,
+        // without calling the functor, if the wait would be a deadlock or if the object has been deleted meanwhile; if the functor
+        // throws an exception, it is thrown again here
+        if(QThread::currentThread() == thread){
+            functor(t_);            // we are already inside the thread of t_, so we call it directly
+            return true;
+        }
+        const void *caller = QThread::currentThread();
+        if(!SyncCallGraph::enter(caller, thread)){
+            return false;           // the deadlock is reported only by the result, like with THREADWRAPPER_STD_BACKEND
+        }
+        bool executed;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(syncCallEnvelope.slot.callerMutex);
+            syncCallEnvelope.slot.template prepare<T>(&functor);
+            inbox()->postEnvelope(&syncCallEnvelope, lane);        // the pre-allocated envelope, so the handoff does not allocate anything
+            executed = syncCallEnvelope.slot.wait();
+            error = syncCallEnvelope.slot.takeError();
+        }
+        SyncCallGraph::leave(caller);
+        if(error){
+            std::rethrow_exception(error);
+        }
+        return executed;
+    }
+
+protected:
+    InboxObject *inbox() const {
+        // thread is always a ThreadObjectTArgX, derived from ThreadObjectTArg0<T>, so the static_cast is safe (and cheap)
+        return static_cast<ThreadObjectTArg0<T>*>(thread)->inboxObject;
+    }
+
 };
 
 
@@ -438,4 +491,6 @@ protected:
 
 
 
+#endif // THREADWRAPPER_STD_BACKEND
+
 #endif // THREADWRAPPER_H
@@ -0,0 +1,327 @@
+/*
+
+    The ThreadWrapperGroup class collects a set of ThreadWrapperX objects sharing the same QObject derived class T, in order to
+    run the same operation on every object T (each one inside its own QThread) and to combine the results.
+
+    The group does not own the wrappers: they must be deleted by the user, after having removed them from the group.
+
+    For example, having some wrappers of a class Worker with a method "quint64 processedItems()", we can collect the total
+    number of processed items in the following way:
+        ThreadWrapperGroup<Worker> group;
+        group.append(threadWrapperWorker1);
+        group.append(threadWrapperWorker2);
+        MapReduceFuture<quint64> future = group.mapReduce([](Worker *worker){ return worker->processedItems(); },
+                                                          [](quint64 total, quint64 items){ return total + items; },
+                                                          quint64(0), 500);
+        quint64 total = future.result();
+    The map callable is called inside the thread of each object T, while the reduce callable (the combiner) is called with
+    the accumulated value and the value returned by a single map, under the lock of the operation.
+    The last argument is an optional timeout (in milliseconds): the objects T which have not replied in time are ignored and
+    the future gives the partial result (the operation is finished at the deadline by a shared timer thread, even if nobody is
+    waiting for the future). In the same way, future.cancel() gives up on the objects T which have not replied yet; if their
+    map has not started yet, it is not executed at all.
+    If a map or the reduce throws an exception, the operation is finished and future.result() throws it again.
+
+*/
+
+
+#ifndef THREADWRAPPERGROUP_H
+#define THREADWRAPPERGROUP_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "threadwrapper.h"
+
+
+class MapReduceDeadlines
+{
+
+    // a single thread, started at the first timed operation, which gives up on the operations at their deadline; an operation
+    // finished before its deadline cancels its entry, so the entries (and the states they keep alive) do not pile up
+
+public:
+    typedef std::pair<std::chrono::steady_clock::time_point, uint64_t> Key;        // the deadline, and a unique ticket
+
+public:
+    static Key schedule(std::chrono::steady_clock::time_point deadline, const std::function<void()> &callback){
+        MapReduceDeadlines &deadlines = instance();
+        std::lock_guard<std::mutex> lock(deadlines.mutex);
+        if(!deadlines.thread.joinable()){
+            deadlines.thread = std::thread(&MapReduceDeadlines::run, &deadlines);
+        }
+        Key key(deadline, ++deadlines.lastTicket);
+        bool earliest = deadlines.callbacks.empty() || key < deadlines.callbacks.begin()->first;
+        deadlines.callbacks.insert(std::make_pair(key, callback));
+        if(earliest){
+            deadlines.condition.notify_one();
+        }
+        return key;
+    }
+    static void cancel(const Key &key){
+        // it does nothing if the callback has already been taken by the thread
+        MapReduceDeadlines &deadlines = instance();
+        std::lock_guard<std::mutex> lock(deadlines.mutex);
+        deadlines.callbacks.erase(key);
+    }
+
+private:
+    MapReduceDeadlines(){
+        stopped = false;
+        lastTicket = 0;
+    }
+    ~MapReduceDeadlines(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        condition.notify_one();
+        if(thread.joinable()){
+            thread.join();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::map<Key, std::function<void()> > callbacks;
+    std::thread thread;
+    uint64_t lastTicket;
+    bool stopped;
+
+private:
+    static MapReduceDeadlines &instance(){
+        static MapReduceDeadlines deadlines;
+        return deadlines;
+    }
+    void run(){
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!stopped){
+            if(callbacks.empty()){
+                condition.wait(lock);
+                continue;
+            }
+            std::chrono::steady_clock::time_point first = callbacks.begin()->first.first;
+            if(std::chrono::steady_clock::now() < first){
+                condition.wait_until(lock, first);
+                continue;
+            }
+            std::function<void()> callback = callbacks.begin()->second;
+            callbacks.erase(callbacks.begin());
+            lock.unlock();
+            callback();             // outside the lock, as it takes the lock of the operation
+            lock.lock();
+        }
+    }
+
+};
+
+
+template <class R>
+class MapReduceState
+{
+
+public:
+    MapReduceState(const R &_initial, int _pending, int _timeout) :
+      accumulator(_initial), pending(_pending), completed(0), deadlineArmed(false), finished(false){
+        future = promise.get_future().share();
+        timed = _timeout >= 0;
+        if(timed){
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeout);
+        }
+        if(pending == 0){
+            giveUp();
+        }
+    }
+
+public:
+    std::shared_future<R> future;
+    std::chrono::steady_clock::time_point deadline;
+    bool timed;
+
+private:
+    std::mutex mutex;
+    std::promise<R> promise;
+    R accumulator;
+    int pending;
+    int completed;
+    MapReduceDeadlines::Key deadlineKey;
+    bool deadlineArmed;             // true while the entry of the operation is in MapReduceDeadlines
+    std::atomic<bool> finished;
+
+public:
+    void armDeadline(const std::shared_ptr<MapReduceState<R> > &self){
+        // the operation is given up at the deadline even if nobody waits for the future
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!timed || finished){
+            return;
+        }
+        std::weak_ptr<MapReduceState<R> > weakState = self;
+        deadlineKey = MapReduceDeadlines::schedule(deadline, [weakState](){
+            std::shared_ptr<MapReduceState<R> > expiredState = weakState.lock();
+            if(expiredState){
+                expiredState->giveUp();
+            }
+        });
+        deadlineArmed = true;
+    }
+    template <class Reduce>
+    void merge(const R &value, Reduce &reduce){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(finished){
+            return;         // cancelled or timed out: the value of a straggler is ignored
+        }
+        if(expired()){
+            finish();
+            return;
+        }
+        accumulator = reduce(accumulator, value);
+        completed++;
+        if(--pending == 0){
+            finish();
+        }
+    }
+    void giveUp(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!finished){
+            finish();
+        }
+    }
+    void fail(std::exception_ptr exception){
+        // the first exception of a map or of the reduce finishes the operation, and it is thrown by future.result()
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!finished){
+            finished = true;
+            disarmDeadline();
+            promise.set_exception(exception);
+        }
+    }
+    bool isFinished() const {return finished;}
+    bool expired() const {return timed && std::chrono::steady_clock::now() >= deadline;}
+    bool isComplete(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending == 0;
+    }
+    int completedCount(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return completed;
+    }
+
+private:
+    void finish(){
+        finished = true;
+        disarmDeadline();
+        promise.set_value(accumulator);
+    }
+    void disarmDeadline(){
+        if(deadlineArmed){
+            MapReduceDeadlines::cancel(deadlineKey);
+            deadlineArmed = false;
+        }
+    }
+
+};
+
+
+template <class R>
+class MapReduceFuture
+{
+
+public:
+    explicit MapReduceFuture(const std::shared_ptr<MapReduceState<R> > &_state){
+        state = _state;
+    }
+
+private:
+    std::shared_ptr<MapReduceState<R> > state;
+
+public:
+    R result(){
+        wait();
+        return state->future.get();
+    }
+    void wait(){
+        if(state->timed){
+            if(state->future.wait_until(state->deadline) == std::future_status::timeout){
+                state->giveUp();            // the timeout is expired, so we give up on the stragglers
+            }
+        }
+        state->future.wait();
+    }
+    bool waitFor(int _msecs){
+        std::chrono::steady_clock::time_point limit = std::chrono::steady_clock::now() + std::chrono::milliseconds(_msecs);
+        if(state->timed && state->deadline < limit){
+            if(state->future.wait_until(state->deadline) == std::future_status::timeout){
+                state->giveUp();
+            }
+            return true;
+        }
+        return state->future.wait_until(limit) == std::future_status::ready;
+    }
+    void cancel(){
+        state->giveUp();
+    }
+    bool isFinished() const {return state->isFinished();}
+    bool isComplete() const {return state->isComplete();}          // true if every object T has replied
+    int completedCount() const {return state->completedCount();}
+
+};
+
+
+template <class T>
+class ThreadWrapperGroup
+{
+
+public:
+    ThreadWrapperGroup(){
+    }
+
+private:
+    std::vector<ThreadWrapper0<T>*> threadWrappers;
+
+public:
+    void append(ThreadWrapper0<T> *_threadWrapper){
+        threadWrappers.push_back(_threadWrapper);
+    }
+    void remove(ThreadWrapper0<T> *_threadWrapper){
+        threadWrappers.erase(std::remove(threadWrappers.begin(), threadWrappers.end(), _threadWrapper), threadWrappers.end());
+    }
+    int size() const {return (int)threadWrappers.size();}
+
+public:
+    template <class R, class Map, class Reduce>
+    MapReduceFuture<R> mapReduce(Map map, Reduce reduce, const R &initial, int timeout = -1){
+        std::shared_ptr<MapReduceState<R> > state = std::make_shared<MapReduceState<R> >(initial, size(), timeout);
+        state->armDeadline(state);
+        for(size_t i = 0; i < threadWrappers.size(); i++){
+            threadWrappers[i]->post([state, map, reduce](T *t) mutable {
+                if(state->isFinished() || state->expired()){
+                    state->giveUp();        // nobody is waiting for this value anymore, so we do not run the map at all
+                    return;
+                }
+                try{
+                    R value = map(t);
+                    state->merge(value, reduce);
+                }
+                catch(...){
+                    state->fail(std::current_exception());      // it must not escape into the event loop of the thread
+                }
+            });
+        }
+        return MapReduceFuture<R>(state);
+    }
+
+};
+
+
+#endif // THREADWRAPPERGROUP_H
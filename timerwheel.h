@@ -0,0 +1,401 @@
+/*
+
+    The TimerWheel class is a hierarchical timing wheel, useful when an object of the QObject derived class T (inside its QThread)
+    needs a lot of timers (for example tens of thousands of per-session timeouts), where a QTimer for each timer is too expensive.
+
+    Each timer is a TimerWheelEntry, usually a member of the session object, with its callback set once in the constructor:
+        TimerWheelEntry timeoutEntry;
+        timeoutEntry.callback = [this](){ closeSession(); };
+    then, inside the thread of T, it can be scheduled, re-armed (scheduling it again) and cancelled in O(1) without any allocation:
+        TimerWheel::forCurrentThread()->schedule(&timeoutEntry, 30000);
+        ....... do stuff .....
+        timeoutEntry.cancel();
+    An entry is cancelled automatically when it is deleted.
+
+    The wheel has 4 levels (256 slots for the first one and 64 slots for the other ones), so with a tick of 1 millisecond the timers
+    up to about 18 hours are exact; longer timers are clamped to the last slot. All the timers expiring in the same tick are
+    expired together, in one iteration of the event loop.
+
+    TimerWheel::forCurrentThread() gives the wheel of the current thread, driven by a single QTimer which runs only when a timer
+    is pending (with THREADWRAPPER_STD_BACKEND it is driven directly by the StdEventLoop of the thread), so every object T has
+    its own wheel without any synchronization. A wheel (and its entries) must be used only inside its thread.
+
+*/
+
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#ifndef THREADWRAPPER_STD_BACKEND
+#include <QObject>
+#include <QThreadStorage>
+#include <QTimer>
+#endif
+
+
+class TimerWheel;
+
+class TimerWheelEntry
+{
+
+public:
+    TimerWheelEntry(){
+        next = this;
+        prev = this;
+        slot = 0;
+        wheel = 0;
+        expires = 0;
+    }
+    explicit TimerWheelEntry(const std::function<void()> &_callback){
+        next = this;
+        prev = this;
+        slot = 0;
+        wheel = 0;
+        expires = 0;
+        callback = _callback;
+    }
+    ~TimerWheelEntry(){
+        cancel();
+    }
+
+public:
+    std::function<void()> callback;
+
+private:
+    friend class TimerWheel;
+    TimerWheelEntry *next;
+    TimerWheelEntry *prev;
+    TimerWheelEntry *slot;          // the head of the list containing the entry, 0 if the entry is not scheduled
+    TimerWheel *wheel;
+    uint64_t expires;
+
+public:
+    bool isScheduled() const {return slot != 0;}
+    inline void cancel();
+
+private:
+    TimerWheelEntry(const TimerWheelEntry &);
+    TimerWheelEntry &operator=(const TimerWheelEntry &);
+
+};
+
+
+class TimerWheel
+{
+
+public:
+    explicit TimerWheel(int _tickMsecs = 1){
+        tickMsecs = _tickMsecs > 0 ? _tickMsecs : 1;
+        start = std::chrono::steady_clock::now();
+        base = 0;
+        count_ = 0;
+        advancing = false;
+        wakeupTick = UINT64_MAX;
+        for(int i = 0; i < 4; i++){
+            occupied[i] = 0;
+        }
+    }
+    virtual ~TimerWheel(){
+        // the pending entries are simply detached, their callbacks are not called
+        for(int i = 0; i < 256; i++){
+            detachAll(&level0[i]);
+        }
+        for(int l = 0; l < 3; l++){
+            for(int i = 0; i < 64; i++){
+                detachAll(&levels[l][i]);
+            }
+        }
+    }
+
+public:
+    static TimerWheel *forCurrentThread();
+
+private:
+    TimerWheelEntry level0[256];
+    TimerWheelEntry levels[3][64];
+    uint64_t occupied[4];           // bitmap of the non-empty slots of level0, used to find the next expiry quickly
+    std::chrono::steady_clock::time_point start;
+    uint64_t base;                  // the next tick to be processed
+    int tickMsecs;
+    int count_;
+    bool advancing;
+
+protected:
+    uint64_t wakeupTick;            // the tick at which the driver is going to call advance(), UINT64_MAX if it is idle
+
+public:
+    void schedule(TimerWheelEntry *entry, int msecs){
+        if(entry->slot){
+            unlink(entry);          // re-arming an entry is just a move between two lists
+        }
+        else{
+            count_++;
+        }
+        uint64_t now = currentTick();
+        if(count_ == 1){
+            base = now;             // the wheel was idle, so there is nothing to catch up
+        }
+        entry->wheel = this;
+        entry->expires = now + (msecs > 0 ? (uint64_t)(msecs + tickMsecs - 1) / tickMsecs : 0);
+        add(entry);
+        if(!advancing && entry->expires < wakeupTick){
+            wakeupChanged();
+        }
+    }
+    void cancel(TimerWheelEntry *entry){
+        if(entry->slot){
+            unlink(entry);
+            count_--;
+        }
+    }
+    int advance(){
+        // we expire all the timers up to now; the callbacks can schedule or cancel any entry
+        int expired = 0;
+        uint64_t now = currentTick();
+        advancing = true;
+        while(count_ > 0 && base <= now){
+            int index = (int)(base & 255);
+            TimerWheelEntry *head = &level0[index];
+            TimerWheelEntry pending;        // we move the whole slot in a local list, so re-armed entries cannot be expired twice
+            if(head->next != head){
+                pending.next = head->next;
+                pending.prev = head->prev;
+                pending.next->prev = &pending;
+                pending.prev->next = &pending;
+                head->next = head;
+                head->prev = head;
+                occupied[index >> 6] &= ~(1ULL << (index & 63));
+                for(TimerWheelEntry *entry = pending.next; entry != &pending; entry = entry->next){
+                    entry->slot = &pending;
+                }
+            }
+            base++;
+            if(!(base & 255)){
+                // eagerly, so nextExpiryTick() sees the timers of the new block in level0; after the slot has been taken,
+                // as the last slot of the block is the first one refilled by the cascade
+                cascadeBlock();
+            }
+            while(pending.next != &pending){
+                TimerWheelEntry *entry = pending.next;
+                unlink(entry);
+                count_--;
+                expired++;
+                if(entry->callback){
+                    entry->callback();
+                }
+            }
+        }
+        advancing = false;
+        return expired;
+    }
+    int nextTimeout() const {
+        // the milliseconds before the next call of advance() is needed, -1 if there are no timers
+        if(count_ == 0){
+            return -1;
+        }
+        uint64_t tick = nextExpiryTick();
+        std::chrono::steady_clock::time_point target = start + std::chrono::milliseconds(tick * tickMsecs);
+        std::chrono::steady_clock::duration remaining = target - std::chrono::steady_clock::now();
+        if(remaining <= std::chrono::steady_clock::duration::zero()){
+            return 0;
+        }
+        return (int)((std::chrono::duration_cast<std::chrono::microseconds>(remaining).count() + 999) / 1000);
+    }
+    uint64_t nextExpiryTick() const {
+        int index = (int)(base & 255);
+        for(int word = index >> 6; word < 4; word++){
+            uint64_t bits = occupied[word];
+            if(word == index >> 6){
+                bits &= ~0ULL << (index & 63);
+            }
+            if(bits){
+                return base + (uint64_t)((word << 6) + lowestBit(bits) - index);
+            }
+        }
+        return base + (uint64_t)(256 - index);     // the start of the next block, when the upper levels are cascaded
+    }
+    int count() const {return count_;}
+    int tick() const {return tickMsecs;}
+
+protected:
+    virtual void wakeupChanged(){
+        // called when a new timer expires before wakeupTick, so the driver must be re-armed
+    }
+    virtual uint64_t currentTick() const {
+        // the clock of the wheel, in ticks; it can be overridden to drive the wheel without waiting (for example in a test)
+        return (uint64_t)(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()) / tickMsecs;
+    }
+
+private:
+    int levelIndex(int level) const {return (int)((base >> (8 + level * 6)) & 63);}
+    void add(TimerWheelEntry *entry){
+        uint64_t expires = entry->expires;
+        uint64_t delta = expires - base;
+        TimerWheelEntry *head;
+        if((int64_t)delta < 0){
+            head = &level0[base & 255];        // already expired, it is going to be processed at the next tick
+        }
+        else if(delta < (1ULL << 8)){
+            head = &level0[expires & 255];
+        }
+        else if(delta < (1ULL << 14)){
+            head = &levels[0][(expires >> 8) & 63];
+        }
+        else if(delta < (1ULL << 20)){
+            head = &levels[1][(expires >> 14) & 63];
+        }
+        else{
+            if(delta >= (1ULL << 26)){
+                expires = base + (1ULL << 26) - 1;
+                entry->expires = expires;
+            }
+            head = &levels[2][(expires >> 20) & 63];
+        }
+        if(head >= level0 && head < level0 + 256){
+            int index = (int)(head - level0);
+            occupied[index >> 6] |= 1ULL << (index & 63);
+        }
+        entry->slot = head;
+        entry->prev = head->prev;
+        entry->next = head;
+        head->prev->next = entry;
+        head->prev = entry;
+    }
+    void unlink(TimerWheelEntry *entry){
+        TimerWheelEntry *head = entry->slot;
+        entry->prev->next = entry->next;
+        entry->next->prev = entry->prev;
+        entry->next = entry;
+        entry->prev = entry;
+        entry->slot = 0;
+        if(head->next == head && head >= level0 && head < level0 + 256){
+            int index = (int)(head - level0);
+            occupied[index >> 6] &= ~(1ULL << (index & 63));
+        }
+    }
+    void cascadeBlock(){
+        // base has just entered a new block of 256 ticks: the due slots are moved down from the highest level to level 0,
+        // so the timers cascaded from an upper level can be cascaded again in the same block
+        if(!levelIndex(0)){
+            if(!levelIndex(1)){
+                cascade(2, levelIndex(2));
+            }
+            cascade(1, levelIndex(1));
+        }
+        cascade(0, levelIndex(0));
+    }
+    void cascade(int level, int index){
+        TimerWheelEntry *head = &levels[level][index];
+        while(head->next != head){
+            TimerWheelEntry *entry = head->next;
+            unlink(entry);
+            add(entry);
+        }
+    }
+    void detachAll(TimerWheelEntry *head){
+        while(head->next != head){
+            TimerWheelEntry *entry = head->next;
+            unlink(entry);
+            entry->wheel = 0;
+        }
+    }
+    static int lowestBit(uint64_t bits){
+#if defined(__GNUC__)
+        return __builtin_ctzll(bits);
+#else
+        int index = 0;
+        while(!(bits & 1)){
+            bits >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+private:
+    TimerWheel(const TimerWheel &);
+    TimerWheel &operator=(const TimerWheel &);
+
+};
+
+
+inline void TimerWheelEntry::cancel(){
+    if(wheel){
+        wheel->cancel(this);
+    }
+}
+
+
+#ifndef THREADWRAPPER_STD_BACKEND
+
+class TimerWheelService : public QObject, public TimerWheel
+{
+
+public:
+    explicit TimerWheelService(int _tickMsecs = 1, QObject *parent = 0) :
+      QObject(parent), TimerWheel(_tickMsecs), timer(this){
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        connect(&timer, &QTimer::timeout, [this](){
+            wakeupTick = UINT64_MAX;
+            advance();
+            rearm();
+        });
+    }
+
+private:
+    QTimer timer;
+
+protected:
+    void wakeupChanged(){
+        rearm();
+    }
+
+private:
+    void rearm(){
+        int timeout = nextTimeout();
+        if(timeout < 0){
+            timer.stop();
+            wakeupTick = UINT64_MAX;
+        }
+        else{
+            timer.start(timeout);
+            wakeupTick = nextExpiryTick();
+        }
+    }
+
+};
+
+
+inline TimerWheel *TimerWheel::forCurrentThread(){
+    // the service is created the first time it is needed, and it is deleted by QThreadStorage at the end of the thread
+    static QThreadStorage<TimerWheelService*> services;
+    if(!services.hasLocalData()){
+        services.setLocalData(new TimerWheelService());
+    }
+    return services.localData();
+}
+
+#else
+
+inline std::unique_ptr<TimerWheel> &stdThreadTimerWheel(){
+    static thread_local std::unique_ptr<TimerWheel> wheel;
+    return wheel;
+}
+
+inline TimerWheel *TimerWheel::forCurrentThread(){
+    // the wheel is driven by the StdEventLoop of the thread, and it is deleted at the end of the thread
+    if(!stdThreadTimerWheel()){
+        stdThreadTimerWheel().reset(new TimerWheel());
+    }
+    return stdThreadTimerWheel().get();
+}
+
+#endif
+
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,328 @@
+/*
+
+    The TrafficNode class counts the calls exchanged between the wrapped objects, for the ColocationPolicy (colocationpolicy.h).
+
+    Every inbox (InboxObject, or StdEventLoop with THREADWRAPPER_STD_BACKEND) has a node, attached to the thread of the object T;
+    when a call is posted by post() or invokeSync() from the thread of another wrapped object, the node of the sender counts it in
+    its own table of destinations, so the counters are written only by the sender thread, without any contention. The table keeps
+    the last 32 destinations of the sender (when it is full, it is cleared). Every node also samples the L3 cache domain of its
+    thread when it wakes up, so a call is counted as local when the sender and the receiver were running in the same domain.
+
+    The tracking is disabled by default (the cost is a relaxed atomic load for every call), and it is enabled by
+    TrafficNode::setTrackingEnabled(true) or by ColocationPolicy::start(). Only the calls of post() and invokeSync() are counted,
+    not the ones of the queued signal-slot connections.
+
+    The CpuTopology class gives the L3 cache domains of the cpus, read from /sys on Linux (the cpus listed in the "online" file, or
+    in the "possible" one, as their numbers can have holes; the physical packages are used when the L3 caches are not described);
+    on the other systems all the cpus are in a single domain.
+
+*/
+
+
+#ifndef TRAFFICNODE_H
+#define TRAFFICNODE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+class CpuTopology
+{
+
+public:
+    static const CpuTopology &instance(){
+        static const CpuTopology topology("/sys/devices/system/cpu");
+        return topology;
+    }
+
+public:
+    explicit CpuTopology(const std::string &_sysfsCpuPath){
+        std::map<std::string, int> domainIndexes;
+        std::string cpuList;
+        if(!readFile(_sysfsCpuPath + "/online", cpuList)){
+            readFile(_sysfsCpuPath + "/possible", cpuList);         // if there is no /sys at all, the list stays empty
+        }
+        std::vector<int> cpuNumbers = parseCpuList(cpuList);
+        for(size_t i = 0; i < cpuNumbers.size(); i++){
+            int cpu = cpuNumbers[i];
+            std::string cpuPath = _sysfsCpuPath + "/cpu" + std::to_string(cpu);
+            std::string key;
+            if(!readFile(cpuPath + "/topology/physical_package_id", key)){
+                continue;       // an offline cpu of the "possible" list
+            }
+            key = "package " + key;
+            for(int index = 0; index < 8; index++){
+                std::string level;
+                std::string shared;
+                std::string cachePath = cpuPath + "/cache/index" + std::to_string(index);
+                if(readFile(cachePath + "/level", level) && level == "3" && readFile(cachePath + "/shared_cpu_list", shared)){
+                    key = "l3 " + shared;
+                    break;
+                }
+            }
+            std::map<std::string, int>::iterator found = domainIndexes.find(key);
+            if(found == domainIndexes.end()){
+                found = domainIndexes.insert(std::make_pair(key, (int)domains.size())).first;
+                domains.push_back(std::vector<int>());
+            }
+            domains[found->second].push_back(cpu);
+            if((int)domainOfCpu.size() <= cpu){
+                domainOfCpu.resize(cpu + 1, 0);
+            }
+            domainOfCpu[cpu] = found->second;
+        }
+        if(domains.empty()){
+            domains.push_back(std::vector<int>());         // a single domain, with unknown cpus
+        }
+    }
+
+private:
+    enum {maxCpus = 8192};          // a bound for a corrupted list
+    std::vector<std::vector<int> > domains;
+    std::vector<int> domainOfCpu;
+
+public:
+    int domainCount() const {return (int)domains.size();}
+    const std::vector<int> &cpus(int domain) const {return domains[domain];}
+    int domainOf(int cpu) const {
+        return cpu >= 0 && cpu < (int)domainOfCpu.size() ? domainOfCpu[cpu] : 0;
+    }
+    int currentDomain() const {
+#if defined(__linux__)
+        return domainOf(sched_getcpu());
+#else
+        return 0;
+#endif
+    }
+
+private:
+    static std::vector<int> parseCpuList(const std::string &list){
+        // the format of the cpu lists of /sys, for example "0-3,8-11"
+        std::vector<int> cpus;
+        const char *text = list.c_str();
+        while(*text){
+            char *end;
+            long first = std::strtol(text, &end, 10);
+            if(end == text || first < 0){
+                break;
+            }
+            long last = first;
+            text = end;
+            if(*text == '-'){
+                last = std::strtol(text + 1, &end, 10);
+                if(end == text + 1 || last < first){
+                    break;
+                }
+                text = end;
+            }
+            for(long cpu = first; cpu <= last && cpu < maxCpus; cpu++){
+                cpus.push_back((int)cpu);
+            }
+            if(*text != ','){
+                break;
+            }
+            text++;
+        }
+        return cpus;
+    }
+    static bool readFile(const std::string &path, std::string &value){
+        FILE *file = std::fopen(path.c_str(), "r");
+        if(!file){
+            return false;
+        }
+        char buffer[256];
+        bool read = std::fgets(buffer, sizeof(buffer), file) != 0;
+        std::fclose(file);
+        value = read ? buffer : "";
+        while(!value.empty() && (value[value.size() - 1] == '\n' || value[value.size() - 1] == ' ')){
+            value.erase(value.size() - 1);
+        }
+        return read;
+    }
+
+};
+
+
+class TrafficNode
+{
+
+public:
+    TrafficNode(){
+        static std::atomic<uint64_t> lastId(0);
+        id_ = ++lastId;
+        edges.store(0);
+        epoch.store(0);
+        domain.store(-1);
+        threadId_.store(0);
+        pinnedByPolicy = false;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registryIndex = registry().size();
+        registry().push_back(this);
+    }
+    ~TrafficNode(){
+        {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            TrafficNode *last = registry().back();
+            registry()[registryIndex] = last;
+            last->registryIndex = registryIndex;
+            registry().pop_back();
+        }
+        if(current() == this){
+            current() = 0;
+        }
+        delete[] edges.load();
+    }
+
+private:
+    friend class ColocationPolicy;
+    struct Edge {
+        std::atomic<uint64_t> receiver;         // the id of the receiver node, 0 for a free entry
+        std::atomic<uint64_t> messages;
+        std::atomic<uint64_t> localMessages;
+    };
+    enum {edgeCount = 32};
+    uint64_t id_;
+    std::atomic<Edge*> edges;                   // allocated by the sender thread when it posts its first tracked call
+    std::atomic<uint64_t> epoch;                // incremented when the table is cleared, so the policy can restart its deltas
+    std::atomic<int> domain;                    // the last sampled L3 domain of the thread, -1 if unknown
+    std::atomic<long> threadId_;                // the kernel id of the thread, 0 when the node is not attached
+    size_t registryIndex;
+#if defined(__linux__)
+    cpu_set_t initialAffinity;                  // the affinity of the thread before the object T was created
+    cpu_set_t policyAffinity;                   // the affinity set by the ColocationPolicy, valid if pinnedByPolicy
+#endif
+    bool pinnedByPolicy;                        // these three members are protected by registryMutex()
+
+public:
+    void attachCurrentThread(){
+        // called inside the thread of the node, before the object T is created
+        std::lock_guard<std::mutex> lock(registryMutex());
+#if defined(__linux__)
+        threadId_.store((long)syscall(SYS_gettid));
+        CPU_ZERO(&initialAffinity);
+        sched_getaffinity(0, sizeof(initialAffinity), &initialAffinity);
+#else
+        threadId_.store(1);
+#endif
+        pinnedByPolicy = false;
+        current() = this;
+    }
+    void detachCurrentThread(){
+        // called inside the thread of the node, when the object T has been deleted
+        std::lock_guard<std::mutex> lock(registryMutex());
+        threadId_.store(0);
+        current() = 0;
+    }
+    void recordPost(){
+        // called by the thread posting a call to this node
+        if(!isTrackingEnabled()){
+            return;
+        }
+        TrafficNode *sender = current();
+        if(sender && sender != this){
+            sender->recordSent(this);
+        }
+    }
+    void sampleDomain(){
+        // called inside the thread of the node when it wakes up
+        if(isTrackingEnabled()){
+            domain.store(CpuTopology::instance().currentDomain(), std::memory_order_relaxed);
+        }
+    }
+    uint64_t id() const {return id_;}
+    long threadId() const {return threadId_.load();}
+
+public:
+    static void setTrackingEnabled(bool enabled){
+        trackingFlag().store(enabled);
+    }
+    static bool isTrackingEnabled(){
+        return trackingFlag().load(std::memory_order_relaxed);
+    }
+
+private:
+    void recordSent(TrafficNode *receiver){
+        // called only by the thread of this node, so the counters need no read-modify-write
+        Edge *table = edges.load(std::memory_order_relaxed);
+        if(!table){
+            table = new Edge[edgeCount];
+            clear(table);
+            edges.store(table, std::memory_order_release);
+        }
+        int senderDomain = domain.load(std::memory_order_relaxed);
+        bool local = senderDomain >= 0 && senderDomain == receiver->domain.load(std::memory_order_relaxed);
+        Edge *edge = find(table, receiver->id_);
+        if(!edge){
+            clear(table);           // too many destinations: we restart with the current ones
+            epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            edge = find(table, receiver->id_);
+        }
+        edge->messages.store(edge->messages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if(local){
+            edge->localMessages.store(edge->localMessages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+    static Edge *find(Edge *table, uint64_t receiver){
+        // it returns the entry of the receiver (claiming a free one if needed), 0 if the table is full
+        int start = (int)((receiver * 0x9E3779B97F4A7C15ULL) >> 59);            // 5 bits, as edgeCount is 32
+        for(int i = 0; i < edgeCount; i++){
+            Edge *edge = &table[(start + i) & (edgeCount - 1)];
+            uint64_t id = edge->receiver.load(std::memory_order_relaxed);
+            if(id == receiver){
+                return edge;
+            }
+            if(id == 0){
+                edge->messages.store(0, std::memory_order_relaxed);
+                edge->localMessages.store(0, std::memory_order_relaxed);
+                edge->receiver.store(receiver, std::memory_order_relaxed);
+                return edge;
+            }
+        }
+        return 0;
+    }
+    static void clear(Edge *table){
+        for(int i = 0; i < edgeCount; i++){
+            table[i].receiver.store(0, std::memory_order_relaxed);
+            table[i].messages.store(0, std::memory_order_relaxed);
+            table[i].localMessages.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static std::atomic<bool> &trackingFlag(){
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+    static TrafficNode *&current(){
+        static thread_local TrafficNode *node = 0;          // the node attached to the current thread, the sender of its calls
+        return node;
+    }
+    static std::mutex &registryMutex(){
+        static std::mutex mutex;
+        return mutex;
+    }
+    static std::vector<TrafficNode*> &registry(){
+        static std::vector<TrafficNode*> nodes;
+        return nodes;
+    }
+
+private:
+    TrafficNode(const TrafficNode &);
+    TrafficNode &operator=(const TrafficNode &);
+
+};
+
+
+#endif // TRAFFICNODE_H